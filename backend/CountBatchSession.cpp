@@ -0,0 +1,150 @@
+#include "CountBatchSession.hpp"
+
+#include <algorithm>
+#include <boost/json/object.hpp>
+#include <boost/json/value.hpp>
+
+#include "Beast.hpp"
+#include "SharedState.hpp"
+#include "ThreadPool.hpp"
+#include "WorkerPool.hpp"
+#include "utils/CharacterKey.hpp"
+
+namespace json = boost::json;
+
+CountBatchSession::CountBatchSession(net::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
+                                     std::vector<Document> documents)
+    : ioc_{ioc},
+      shared_state_{shared_state},
+      documents_{std::move(documents)},
+      results_(documents_.size()),
+      remaining_{documents_.size()} {}
+
+void CountBatchSession::run(Handler handler) {
+    handler_ = std::move(handler);
+    start_ = metrics::Clock::now();
+
+    if (documents_.empty()) {
+        net::post(ioc_, beast::bind_front_handler(&CountBatchSession::onBatchCounted, shared_from_this()));
+        return;
+    }
+
+    if (shared_state_->getCountMode() == CountMode::worker_pool) {
+        for (std::size_t i = 0; i < documents_.size(); ++i) {
+            auto const& document = documents_[i];
+
+            auto const submitted = shared_state_->getWorkerPool().submit(
+                document.characters, document.data, [self = shared_from_this(), i](worker::Response response) {
+                    self->results_[i] = std::move(response);
+                    self->onCounted(1);
+                });
+
+            if (!submitted) {
+                results_[i] = {worker::Status::error, {}, "Server is busy"};
+                onCounted(1);
+            }
+        }
+        return;
+    }
+
+    auto& scheduler = shared_state_->getJobScheduler();
+
+    // Batch takes a single slot of the scheduler, its documents are counted in parallel
+    auto const submitted = scheduler.submit(
+        [self = shared_from_this()](JobScheduler::Slot slot) { self->start(std::move(slot)); },
+        [self = shared_from_this()] { self->fail("Request timed out in the queue"); });
+
+    if (!submitted) {
+        metrics::increment(metrics::Counter::jobs_rejected);
+        fail("Server is busy");
+    }
+}
+
+void CountBatchSession::start(JobScheduler::Slot slot) {
+    slot_.emplace(std::move(slot));
+
+    auto& pool = shared_state_->getComputePool();
+
+    std::size_t total_size = 0;
+    for (auto const& document : documents_) {
+        total_size += document.data->size();
+    }
+
+    // Small documents are grouped, so that a task per document doesn't cost more than its counting
+    auto const tasks_count = std::min<std::size_t>(pool.size(), documents_.size());
+    auto const task_size = total_size / tasks_count + 1;
+
+    std::size_t begin = 0;
+    std::size_t size = 0;
+
+    for (std::size_t i = 0; i < documents_.size(); ++i) {
+        size += documents_[i].data->size();
+
+        if (size >= task_size || i + 1 == documents_.size()) {
+            pool.post([self = shared_from_this(), begin, end = i + 1] { self->count(begin, end); });
+            begin = i + 1;
+            size = 0;
+        }
+    }
+}
+
+void CountBatchSession::fail(std::string_view error) {
+    for (auto& result : results_) {
+        result = {worker::Status::error, {}, std::string{error}};
+    }
+
+    net::post(ioc_, beast::bind_front_handler(&CountBatchSession::onBatchCounted, shared_from_this()));
+}
+
+void CountBatchSession::count(std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+        auto const& document = documents_[i];
+
+        counter::Histogram counts{};
+        counter::countBlock(*document.data, document.characters, counts);
+
+        auto& result = results_[i];
+        result.status = worker::Status::ok;
+
+        for (auto const c : document.characters.characters()) {
+            result.counts.push_back(counts[static_cast<unsigned char>(c)]);
+        }
+    }
+
+    onCounted(end - begin);
+}
+
+void CountBatchSession::onCounted(std::size_t documents_count) {
+    if (remaining_.fetch_sub(documents_count, std::memory_order_acq_rel) == documents_count) {
+        net::post(ioc_, beast::bind_front_handler(&CountBatchSession::onBatchCounted, shared_from_this()));
+    }
+}
+
+void CountBatchSession::onBatchCounted() {
+    json::array results;
+    results.reserve(results_.size());
+
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+        auto const& result = results_[i];
+
+        if (result.status != worker::Status::ok) {
+            results.push_back(json::value{{"error", result.error}});
+            continue;
+        }
+
+        auto const& characters = documents_[i].characters.characters();
+
+        json::object counts;
+        for (std::size_t j = 0; j < characters.size() && j < result.counts.size(); ++j) {
+            counts[utils::getCharacterKey(characters[j])] = result.counts[j];
+        }
+
+        results.push_back(std::move(counts));
+    }
+
+    // Next job of the scheduler is started once the documents are counted
+    slot_.reset();
+
+    metrics::observeSince(metrics::Histogram::count, start_);
+    handler_(std::move(results));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <boost/json/array.hpp>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "CountPayload.hpp"
+#include "Counter.hpp"
+#include "JobScheduler.hpp"
+#include "Metrics.hpp"
+#include "Net.hpp"
+#include "WorkerProtocol.hpp"
+
+class SharedState;
+
+/**
+ * @brief Counts a batch of documents, every document with its own characters.
+ * Documents are split into a few contiguous runs of similar size which are counted
+ * on the compute pool, in CountMode::worker_pool every document is a worker job.
+ * Batch on the compute pool is a single job of the job scheduler, so it's admitted the same
+ * way as the other counting. Handler gets the results of all documents at once.
+ */
+class CountBatchSession : public std::enable_shared_from_this<CountBatchSession> {
+public:
+    struct Document {
+        SharedData data;
+        counter::CharacterSet characters;
+    };
+
+    /**
+     * @brief Called on the io context with the results in the order of the documents. Result of
+     * the document is an object which maps characters to the counts, or {"error": "..."}.
+     */
+    using Handler = std::function<void(boost::json::array results)>;
+
+    CountBatchSession(net::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
+                      std::vector<Document> documents);
+
+    /**
+     * @brief Queues counting of all documents
+     *
+     * @param handler Called when all documents are counted
+     */
+    void run(Handler handler);
+
+private:
+    /**
+     * @brief Queues the documents on the compute pool once the batch is admitted
+     *
+     * @param slot Scheduler slot, held until all documents are counted
+     */
+    void start(JobScheduler::Slot slot);
+
+    /**
+     * @brief Fails all documents of the batch which cannot be counted
+     *
+     * @param error Why the batch is not counted
+     */
+    void fail(std::string_view error);
+
+    /**
+     * @brief Counts the documents in [begin, end), called on the compute pool thread
+     */
+    void count(std::size_t begin, std::size_t end);
+
+    /**
+     * @brief Marks documents as counted, the last one posts the results to the io context
+     */
+    void onCounted(std::size_t documents_count);
+
+    /**
+     * @brief Passes the results to the handler, called in the io context
+     */
+    void onBatchCounted();
+
+    net::io_context& ioc_;
+    std::shared_ptr<SharedState> shared_state_;
+    std::vector<Document> documents_;
+    // Every document result is written by a single task, they are read after all tasks are done
+    std::vector<worker::Response> results_;
+    std::atomic<std::size_t> remaining_;
+    Handler handler_;
+    // Start of the counting, for the count latency
+    metrics::Clock::time_point start_;
+    std::optional<JobScheduler::Slot> slot_;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <variant>
+
+/**
+ * @brief Data shared with the counter. Owner of the pointer keeps the viewed storage
+ * (parsed request body) alive, so the data is not copied out of it.
+ */
+using SharedData = std::shared_ptr<std::string_view const>;
+
+/**
+ * @brief Text which is counted. Request data is shared in memory with the counter,
+ * only data over the temporary file threshold is written to the temporary storage
+ * and passed as the file path. Counting session removes the file when it's done.
+ */
+using CountPayload = std::variant<SharedData, std::filesystem::path>;
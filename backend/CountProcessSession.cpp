@@ -1,6 +1,9 @@
 #include "CountProcessSession.hpp"
 
+#include <boost/uuid/uuid_io.hpp>
+#include <cstdint>
 #include <iostream>
+#include <string>
 
 #include "Beast.hpp"
 #include "SharedState.hpp"
@@ -11,32 +14,176 @@ namespace fs = std::filesystem;
 
 auto constexpr BUFFER_LIMIT{2000U};
 
+// chcount input file path which stands for the standard input
+auto constexpr STDIN_PATH{"-"};
+
 CountProcessSession::CountProcessSession(boost::asio::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
                                          uuids::uuid user_id, uuids::uuid request_id, char count_char,
-                                         fs::path file_path)
-    : buf_(BUFFER_LIMIT),
+                                         CountPayload payload, std::optional<ResultCache::Key> cache_key)
+    : ioc_{ioc},
+      strand_{net::make_strand(ioc)},
+      buf_(BUFFER_LIMIT),
       user_id_{std::move(user_id)},
       request_id_{std::move(request_id)},
       ap_{ioc},
-      file_path_{fs::absolute(file_path)},
+      in_ap_{ioc},
+      payload_{std::move(payload)},
       count_char_{count_char},
-      shared_state_{shared_state} {}
+      cache_key_{std::move(cache_key)},
+      start_{metrics::Clock::now()},
+      timer_{ioc},
+      shared_state_{shared_state} {
+    if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+        payload_ = fs::absolute(*file_path);
+    }
+}
+
+CountProcessSession::~CountProcessSession() {
+    if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+        std::error_code ec;
+        fs::remove(*file_path, ec);
+    }
+}
+
+void CountProcessSession::run(JobScheduler::Slot slot) {
+    // Timer and the flags are touched by the handlers on the strand only
+    net::post(strand_, [self = shared_from_this(), slot = std::move(slot)]() mutable { self->start(std::move(slot)); });
+}
+
+void CountProcessSession::start(JobScheduler::Slot slot) {
+    slot_.emplace(std::move(slot));
+
+    auto const& executable = shared_state_->getChcountExecutablePath().string();
+    auto const count_char = std::string(1, count_char_);
+    auto const spawn_start = metrics::Clock::now();
+
+    // Child is reaped asynchronously on SIGCHLD, exit handler continues on the strand
+    auto on_exit = [self = shared_from_this()](int exit_code, std::error_code const& ec) {
+        net::post(self->strand_, [self, exit_code, ec] { self->onExit(exit_code, ec); });
+    };
 
-CountProcessSession::~CountProcessSession() { fs::remove(file_path_); }
+    try {
+        if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+            child_ = bp::child(executable, "-c", count_char, "-f", file_path->string(), bp::std_out > ap_, ioc_,
+                               bp::on_exit(on_exit));
+        } else {
+            // Payload is written straight to the child standard input
+            auto const& data = std::get<SharedData>(payload_);
 
-void CountProcessSession::run() {
-    child_ = bp::child(shared_state_->getChcountExecutablePath().string(), "-c", std::string(1, count_char_), "-f",
-                       file_path_.string(), bp::std_out > ap_);
+            child_ = bp::child(executable, "-c", count_char, "-f", STDIN_PATH, bp::std_in < in_ap_,
+                               bp::std_out > ap_, ioc_, bp::on_exit(on_exit));
+
+            net::async_write(in_ap_, boost::asio::buffer(data->data(), data->size()),
+                             beast::bind_front_handler(&CountProcessSession::onWrite, shared_from_this()));
+        }
+    } catch (bp::process_error const& e) {
+        std::cerr << "CountProcessSession::start: " << e.what() << std::endl;
+        sendError("Counting failed");
+        return;
+    }
 
-    net::async_read(ap_, boost::asio::buffer(buf_),
-                    beast::bind_front_handler(&CountProcessSession::onRead, shared_from_this()));
-};
+    metrics::observeSince(metrics::Histogram::process_spawn, spawn_start);
+
+    net::async_read(
+        ap_, boost::asio::buffer(buf_),
+        net::bind_executor(strand_, beast::bind_front_handler(&CountProcessSession::onRead, shared_from_this())));
+
+    if (auto const timeout = shared_state_->getJobScheduler().getJobTimeout(); timeout.count() > 0) {
+        timer_.expires_after(timeout);
+        timer_.async_wait(net::bind_executor(
+            strand_, beast::bind_front_handler(&CountProcessSession::onTimeout, shared_from_this())));
+    }
+}
+
+void CountProcessSession::onWrite(boost::system::error_code ec, std::size_t) {
+    if (ec) {
+        std::cerr << "CountProcessSession::onWrite: " << ec.message() << std::endl;
+    }
+
+    // End of the input for the child
+    in_ap_.close();
+}
 
 void CountProcessSession::onRead(boost::system::error_code ec, std::size_t size) {
+    // Output of the killed process is incomplete
+    if (timed_out_) {
+        return;
+    }
+
     if (ec != boost::asio::error::eof) {
         std::cerr << "CountProcessSession::onRead: " << ec.message() << std::endl;
+        sendError("Counting failed");
+        return;
+    }
+
+    // Process which crashed or failed writes nothing
+    if (size == 0) {
+        std::cerr << "CountProcessSession::onRead: chcount exited without output" << std::endl;
+        sendError("Counting failed");
+        return;
+    }
+
+    // Output is the count followed by a new line
+    auto const output = std::string(buf_.cbegin(), buf_.cbegin() + size - 1);
+    std::uint64_t result;
+
+    try {
+        result = std::stoull(output);
+    } catch (std::logic_error const&) {
+        std::cerr << "CountProcessSession::onRead: Unexpected chcount output \"" << output << "\"" << std::endl;
+        sendError("Counting failed");
+        return;
+    }
+
+    metrics::observeSince(metrics::Histogram::count, start_);
+
+    if (cache_key_) {
+        shared_state_->getResultCache().insert(std::move(*cache_key_), {result});
+    }
+
+    replied_ = true;
+    shared_state_->send(user_id_, request_id_, result);
+}
+
+void CountProcessSession::onExit(int exit_code, std::error_code const& ec) {
+    exited_ = true;
+    timer_.cancel();
+
+    // Process killed by the timeout can be reaped by terminate() before the exit handler
+    if (ec && !timed_out_) {
+        std::cerr << "CountProcessSession::onExit: " << ec.message() << std::endl;
+    } else if (exit_code != 0 && !timed_out_) {
+        std::cerr << "CountProcessSession::onExit: chcount exited with code " << exit_code << std::endl;
+    }
+}
+
+void CountProcessSession::onTimeout(boost::system::error_code ec) {
+    if (ec == net::error::operation_aborted || exited_) {
+        return;
+    }
+
+    std::cerr << "CountProcessSession::onTimeout: chcount runs too long, request \""
+              << uuids::to_string(request_id_) << "\" is dropped" << std::endl;
+
+    timed_out_ = true;
+    metrics::increment(metrics::Counter::jobs_timed_out);
+    sendError("Counting timed out");
+
+    // Exit handler stores the exit status before it's posted to the strand, so the process which is
+    // already reaped (and its pid possibly reused) is not killed. Pipes are closed when it's killed.
+    std::error_code terminate_ec;
+    child_.terminate(terminate_ec);
+
+    if (terminate_ec) {
+        std::cerr << "CountProcessSession::onTimeout: " << terminate_ec.message() << std::endl;
+    }
+}
+
+void CountProcessSession::sendError(std::string_view error) {
+    if (replied_) {
         return;
     }
 
-    shared_state_->send(user_id_, request_id_, std::string(buf_.cbegin(), buf_.cbegin() + size - 1));
+    replied_ = true;
+    shared_state_->sendError(user_id_, request_id_, error);
 }
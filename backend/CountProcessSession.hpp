@@ -4,8 +4,15 @@
 #include <boost/process.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
+#include "CountPayload.hpp"
+#include "JobScheduler.hpp"
+#include "Metrics.hpp"
 #include "Net.hpp"
+#include "ResultCache.hpp"
 
 class SharedState;
 
@@ -13,16 +20,33 @@ class CountProcessSession : public std::enable_shared_from_this<CountProcessSess
 public:
     CountProcessSession(net::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
                         boost::uuids::uuid user_id, boost::uuids::uuid request_id, char count_char,
-                        std::filesystem::path file_path);
+                        CountPayload payload, std::optional<ResultCache::Key> cache_key = {});
 
     ~CountProcessSession();
 
     /**
-     * @brief Runs new count process and read from a pipe in provided context
+     * @brief Runs new count process and read from a pipe in provided context.
+     * Process is started on the strand of the session, so it can be called from any thread.
+     *
+     * @param slot Scheduler slot, held until the process exits and its output is read
      */
-    void run();
+    void run(JobScheduler::Slot slot);
 
 private:
+    /**
+     * @brief Starts the count process, called on the strand
+     *
+     * @param slot Scheduler slot
+     */
+    void start(JobScheduler::Slot slot);
+
+    /**
+     * @brief Sends the error to the user, unless the result or an error is already sent
+     *
+     * @param error Why the request was not counted
+     */
+    void sendError(std::string_view error);
+
     /**
      * @brief Handle the data after the async pipe read is done
      *
@@ -31,12 +55,51 @@ private:
      */
     void onRead(boost::system::error_code ec, std::size_t size);
 
+    /**
+     * @brief Closes the child standard input after the payload is written
+     *
+     * @param ec Error code
+     */
+    void onWrite(boost::system::error_code ec, std::size_t);
+
+    /**
+     * @brief Handler called after the child process exited and was reaped
+     *
+     * @param exit_code Exit code of the process
+     * @param ec Error code
+     */
+    void onExit(int exit_code, std::error_code const& ec);
+
+    /**
+     * @brief Kills the child process which runs longer than the job timeout
+     *
+     * @param ec Error code
+     */
+    void onTimeout(boost::system::error_code ec);
+
+    net::io_context& ioc_;
+    // Serializes the read, exit and timeout handlers
+    net::strand<net::io_context::executor_type> strand_;
     std::vector<char> buf_;
     boost::uuids::uuid user_id_;
     boost::uuids::uuid request_id_;
     boost::process::async_pipe ap_;
-    std::filesystem::path file_path_;
+    // Child standard input, used when the payload is in memory
+    boost::process::async_pipe in_ap_;
+    CountPayload payload_;
     char count_char_;
+    // Key under which the result is cached, empty when the result is not cached
+    std::optional<ResultCache::Key> cache_key_;
+    // Start of the counting, for the count latency
+    metrics::Clock::time_point start_;
     boost::process::child child_;
+    net::steady_timer timer_;
+    // Set when the process is killed by the timeout, its output is ignored
+    bool timed_out_{false};
+    bool exited_{false};
+    // Set when the result or an error is sent to the user
+    bool replied_{false};
     std::shared_ptr<SharedState> shared_state_;
+    // Released last, after the process is reaped and the temporary file is removed
+    std::optional<JobScheduler::Slot> slot_;
 };
@@ -0,0 +1,69 @@
+#include "CountTaskSession.hpp"
+
+#include <iostream>
+#include <system_error>
+
+#include "Beast.hpp"
+#include "CountKernel.hpp"
+#include "MappedFile.hpp"
+#include "SharedState.hpp"
+#include "ThreadPool.hpp"
+
+namespace uuids = boost::uuids;
+namespace fs = std::filesystem;
+
+CountTaskSession::CountTaskSession(net::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
+                                   uuids::uuid user_id, uuids::uuid request_id, char count_char, CountPayload payload,
+                                   std::optional<ResultCache::Key> cache_key)
+    : ioc_{ioc},
+      user_id_{std::move(user_id)},
+      request_id_{std::move(request_id)},
+      payload_{std::move(payload)},
+      count_char_{count_char},
+      cache_key_{std::move(cache_key)},
+      start_{metrics::Clock::now()},
+      shared_state_{shared_state} {}
+
+CountTaskSession::~CountTaskSession() {
+    if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+        std::error_code ec;
+        fs::remove(*file_path, ec);
+    }
+}
+
+void CountTaskSession::run(JobScheduler::Slot slot) {
+    slot_.emplace(std::move(slot));
+    shared_state_->getComputePool().post([self = shared_from_this()] { self->count(); });
+}
+
+void CountTaskSession::count() {
+    std::optional<std::uint64_t> result;
+
+    try {
+        if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+            MappedFile file{*file_path};
+            result = kernel::count(file.slice(0, file.size()), count_char_);
+        } else {
+            result = kernel::count(*std::get<SharedData>(payload_), count_char_);
+        }
+    } catch (std::system_error const& e) {
+        std::cerr << "CountTaskSession::count: " << e.what() << std::endl;
+    }
+
+    net::post(ioc_, beast::bind_front_handler(&CountTaskSession::onCount, shared_from_this(), result));
+}
+
+void CountTaskSession::onCount(std::optional<std::uint64_t> result) {
+    if (!result) {
+        shared_state_->sendError(user_id_, request_id_, "Counting failed");
+        return;
+    }
+
+    metrics::observeSince(metrics::Histogram::count, start_);
+
+    if (cache_key_) {
+        shared_state_->getResultCache().insert(std::move(*cache_key_), {*result});
+    }
+
+    shared_state_->send(user_id_, request_id_, *result);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "CountPayload.hpp"
+#include "JobScheduler.hpp"
+#include "Metrics.hpp"
+#include "Net.hpp"
+#include "ResultCache.hpp"
+
+class SharedState;
+
+/**
+ * @brief Counts the characters in-process on the shared compute pool.
+ * Counting is done without the child process and the pipe, result is
+ * delivered back on the io context.
+ */
+class CountTaskSession : public std::enable_shared_from_this<CountTaskSession> {
+public:
+    CountTaskSession(net::io_context& ioc, std::shared_ptr<SharedState> const& shared_state,
+                     boost::uuids::uuid user_id, boost::uuids::uuid request_id, char count_char,
+                     CountPayload payload, std::optional<ResultCache::Key> cache_key = {});
+
+    ~CountTaskSession();
+
+    /**
+     * @brief Queues counting on the compute pool
+     *
+     * @param slot Scheduler slot, held until the result is sent
+     */
+    void run(JobScheduler::Slot slot);
+
+private:
+    /**
+     * @brief Counts the characters, called on the compute pool thread
+     */
+    void count();
+
+    /**
+     * @brief Handle the result after the counting is done, called in the io context
+     *
+     * @param result Count or empty if counting failed
+     */
+    void onCount(std::optional<std::uint64_t> result);
+
+    net::io_context& ioc_;
+    boost::uuids::uuid user_id_;
+    boost::uuids::uuid request_id_;
+    CountPayload payload_;
+    char count_char_;
+    // Key under which the result is cached, empty when the result is not cached
+    std::optional<ResultCache::Key> cache_key_;
+    // Start of the counting, for the count latency
+    metrics::Clock::time_point start_;
+    std::shared_ptr<SharedState> shared_state_;
+    std::optional<JobScheduler::Slot> slot_;
+};
@@ -0,0 +1,59 @@
+#include "CountWorkerSession.hpp"
+
+#include <boost/uuid/uuid_io.hpp>
+#include <iostream>
+
+#include "Beast.hpp"
+#include "SharedState.hpp"
+#include "WorkerPool.hpp"
+
+namespace uuids = boost::uuids;
+namespace fs = std::filesystem;
+
+CountWorkerSession::CountWorkerSession(std::shared_ptr<SharedState> const& shared_state, uuids::uuid user_id,
+                                       uuids::uuid request_id, char count_char, CountPayload payload,
+                                       std::optional<ResultCache::Key> cache_key)
+    : user_id_{std::move(user_id)},
+      request_id_{std::move(request_id)},
+      payload_{std::move(payload)},
+      count_char_{count_char},
+      cache_key_{std::move(cache_key)},
+      start_{metrics::Clock::now()},
+      shared_state_{shared_state} {}
+
+CountWorkerSession::~CountWorkerSession() {
+    if (auto const* file_path = std::get_if<fs::path>(&payload_)) {
+        std::error_code ec;
+        fs::remove(*file_path, ec);
+    }
+}
+
+void CountWorkerSession::run() {
+    counter::CharacterSet characters;
+    characters.insert(count_char_);
+
+    auto const submitted = shared_state_->getWorkerPool().submit(
+        std::move(characters), payload_, beast::bind_front_handler(&CountWorkerSession::onCount, shared_from_this()));
+
+    if (!submitted) {
+        std::cerr << "CountWorkerSession::run: Worker pool is saturated, request \"" << uuids::to_string(request_id_)
+                  << "\" is dropped" << std::endl;
+        shared_state_->sendError(user_id_, request_id_, "Server is busy");
+    }
+}
+
+void CountWorkerSession::onCount(worker::Response response) {
+    if (response.status != worker::Status::ok || response.counts.size() != 1) {
+        std::cerr << "CountWorkerSession::onCount: " << response.error << std::endl;
+        shared_state_->sendError(user_id_, request_id_, response.error.empty() ? "Counting failed" : response.error);
+        return;
+    }
+
+    metrics::observeSince(metrics::Histogram::count, start_);
+
+    if (cache_key_) {
+        shared_state_->getResultCache().insert(std::move(*cache_key_), response.counts);
+    }
+
+    shared_state_->send(user_id_, request_id_, response.counts.front());
+}
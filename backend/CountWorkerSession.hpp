@@ -0,0 +1,49 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+#include <optional>
+
+#include "CountPayload.hpp"
+#include "Metrics.hpp"
+#include "Net.hpp"
+#include "ResultCache.hpp"
+#include "WorkerProtocol.hpp"
+
+class SharedState;
+
+/**
+ * @brief Counts the characters on the pool of persistent chcount worker processes.
+ * Isolation of the counting is the same as with CountProcessSession, but no process
+ * is started per request.
+ */
+class CountWorkerSession : public std::enable_shared_from_this<CountWorkerSession> {
+public:
+    CountWorkerSession(std::shared_ptr<SharedState> const& shared_state, boost::uuids::uuid user_id,
+                       boost::uuids::uuid request_id, char count_char, CountPayload payload,
+                       std::optional<ResultCache::Key> cache_key = {});
+
+    ~CountWorkerSession();
+
+    /**
+     * @brief Queues counting on the worker pool
+     */
+    void run();
+
+private:
+    /**
+     * @brief Handle the worker response, called on the worker pool strand
+     *
+     * @param response Worker response
+     */
+    void onCount(worker::Response response);
+
+    boost::uuids::uuid user_id_;
+    boost::uuids::uuid request_id_;
+    CountPayload payload_;
+    char count_char_;
+    // Key under which the result is cached, empty when the result is not cached
+    std::optional<ResultCache::Key> cache_key_;
+    // Start of the counting, for the count latency
+    metrics::Clock::time_point start_;
+    std::shared_ptr<SharedState> shared_state_;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+
+#include "Beast.hpp"
+#include "Counter.hpp"
+
+/**
+ * @brief HTTP request body which is never stored. Characters are counted in every
+ * chunk of the body as it arrives, so memory use doesn't depend on the body size.
+ */
+struct CountingBody {
+    struct value_type {
+        // Characters which are counted, set before the body is read
+        counter::CharacterSet characters;
+        counter::Histogram counts{};
+        std::uint64_t size{0};
+    };
+
+    class reader {
+    public:
+        template <bool isRequest, class Fields>
+        reader(http::header<isRequest, Fields>&, value_type& body) : body_{body} {}
+
+        void init(boost::optional<std::uint64_t> const&, beast::error_code& ec) { ec = {}; }
+
+        template <class ConstBufferSequence>
+        std::size_t put(ConstBufferSequence const& buffers, beast::error_code& ec) {
+            std::size_t size = 0;
+
+            for (auto const buffer : beast::buffers_range_ref(buffers)) {
+                counter::countBlock({static_cast<char const*>(buffer.data()), buffer.size()}, body_.characters,
+                                    body_.counts);
+                size += buffer.size();
+            }
+
+            body_.size += size;
+            ec = {};
+            return size;
+        }
+
+        void finish(beast::error_code& ec) { ec = {}; }
+
+    private:
+        value_type& body_;
+    };
+};
@@ -1,5 +1,7 @@
 #include "HttpSession.hpp"
 
+#include <sys/sendfile.h>
+
 #include <boost/format.hpp>
 #include <boost/json/kind.hpp>
 #include <boost/json/parse.hpp>
@@ -8,23 +10,70 @@
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <cerrno>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
+#include "CountBatchSession.hpp"
+#include "CountKernel.hpp"
+#include "CountPayload.hpp"
 #include "CountProcessSession.hpp"
+#include "CountTaskSession.hpp"
+#include "CountWorkerSession.hpp"
+#include "JobScheduler.hpp"
+#include "Metrics.hpp"
+#include "ResultCache.hpp"
+#include "SharedBufferBody.hpp"
 #include "SharedState.hpp"
+#include "StaticFileCache.hpp"
 #include "WebSocketSession.hpp"
+#include "WorkerPool.hpp"
+#include "dto/CountBatchDto.hpp"
 #include "dto/CountDto.hpp"
+#include "dto/JsonArena.hpp"
+#include "utils/CharacterKey.hpp"
 #include "utils/ContentType.hpp"
 #include "utils/MimeType.hpp"
 #include "utils/Response.hpp"
+#include "utils/Url.hpp"
 
 namespace uuids = boost::uuids;
 namespace fs = std::filesystem;
 namespace json = boost::json;
 using namespace utils;
 
+// Target of the counting requests
+auto constexpr COUNT_TARGET{"/api/count"};
+
+// Target of the batch counting requests
+auto constexpr BATCH_TARGET{"/api/count/batch"};
+
+// Batch request body limit, the other requests are limited to 20000 bytes
+auto constexpr BATCH_BODY_LIMIT{4 * 1024 * 1024U};
+
+// Target of the streaming uploads
+auto constexpr STREAM_TARGET{"/api/count/stream"};
+
+// Target of the server statistics
+auto constexpr STATS_TARGET{"/api/stats"};
+
+// Target of the metrics in the Prometheus text format
+auto constexpr METRICS_TARGET{"/metrics"};
+
+// Characters which are counted when the request doesn't specify them
+auto constexpr DEFAULT_CHARACTERS{"I"};
+
+// Read buffer size of the streaming upload, reads are sized by the buffer capacity
+auto constexpr STREAM_BUFFER_SIZE{64 * 1024U};
+
+// Maximum size of the file part sent by a single sendfile call
+auto constexpr SENDFILE_CHUNK_SIZE{1024 * 1024U};
+
+// Retry-After of the requests rejected by the saturated worker pool
+auto constexpr WORKER_POOL_RETRY_AFTER{std::chrono::seconds{1}};
+
 // Utilities
 
 namespace {
@@ -32,15 +81,154 @@ namespace {
 struct HandleRequestResult {
     template <class Body>
     HandleRequestResult(http::response<Body> res, std::optional<uuids::uuid> uid = {},
-                        std::optional<uuids::uuid> rid = {}, std::optional<fs::path> tmp = {})
-        : msg{std::move(res)}, user_id{std::move(uid)}, request_id{std::move(rid)}, tmp_file{std::move(tmp)} {}
+                        std::optional<uuids::uuid> rid = {}, std::optional<CountPayload> pl = {})
+        : msg{http::message_generator{std::move(res)}},
+          user_id{std::move(uid)},
+          request_id{std::move(rid)},
+          payload{std::move(pl)} {}
+
+    // File which is sent without reading it into the memory
+    explicit HandleRequestResult(HttpSession::FileTransfer transfer) : file_transfer{std::move(transfer)} {}
 
-    http::message_generator msg;
+    // Batch whose results are sent in the response, response is sent after the batch is counted
+    HandleRequestResult(std::vector<CountBatchSession::Document> docs, http::response<http::string_body> res)
+        : batch{std::move(docs)}, batch_response{std::move(res)} {}
+
+    // Empty when the response is sent later
+    std::optional<http::message_generator> msg{};
     std::optional<uuids::uuid> user_id{};
     std::optional<uuids::uuid> request_id{};
-    std::optional<fs::path> tmp_file{};
+    std::optional<CountPayload> payload{};
+    // Key under which the counting result is cached
+    std::optional<ResultCache::Key> cache_key{};
+    // Result found in the cache, it is sent without counting
+    std::optional<std::uint64_t> cached_result{};
+
+    std::optional<std::vector<CountBatchSession::Document>> batch{};
+    // Response to which the batch results are written, empty when results are sent over the WebSocket
+    std::optional<http::response<http::string_body>> batch_response{};
+
+    std::optional<HttpSession::FileTransfer> file_transfer{};
 };
 
+/**
+ * @brief Parsed batch request which is shared with the counting
+ */
+struct SharedCountBatchDto {
+    SharedCountBatchDto(std::shared_ptr<dto::JsonArena> a, dto::CountBatchDto d)
+        : arena{std::move(a)}, dto{std::move(d)} {}
+
+    // Storage of the parsed body, destroyed last
+    std::shared_ptr<dto::JsonArena> arena;
+    dto::CountBatchDto dto;
+    std::vector<std::string_view> data;
+};
+
+/**
+ * @brief Parsed count request which is shared with the counting
+ */
+struct SharedCountDto {
+    SharedCountDto(std::shared_ptr<dto::JsonArena> a, std::string b)
+        : arena{std::move(a)}, body{std::move(b)}, dto{dto::CountDto::parse(body, arena->storage())} {}
+
+    // Storage of the unescaped data, destroyed last
+    std::shared_ptr<dto::JsonArena> arena;
+    // Request body, data without escapes is a view into it
+    std::string body;
+    dto::CountDto dto;
+    std::string_view data;
+};
+
+/**
+ * @brief Creates the response to the asynchronous count request, result is sent over the WebSocket
+ */
+template <class Body, class Allocator>
+http::response<http::string_body> createRequestIdResponse(http::request<Body, http::basic_fields<Allocator>> const& req,
+                                                          uuids::uuid request_id) {
+    json::value response_body{{"request_id", uuids::to_string(request_id)}};
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, ::content_type::text_plain);
+    res.body() = json::serialize(response_body);
+    res.keep_alive(req.keep_alive());
+    res.prepare_payload();
+
+    return res;
+}
+
+/**
+ * @brief Returns true if the Accept-Encoding header accepts the content coding
+ */
+bool acceptsEncoding(beast::string_view accept_encoding, beast::string_view coding) {
+    for (auto const& encoding : http::ext_list{accept_encoding}) {
+        if (!beast::iequals(encoding.first, coding)) {
+            continue;
+        }
+
+        for (auto const& param : encoding.second) {
+            // Coding with zero quality is not acceptable
+            if (beast::iequals(param.first, "q")) {
+                return param.second.find_first_not_of("0.") != beast::string_view::npos;
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Creates the response with the cached asset, in the smallest encoding the client accepts
+ */
+template <class Body, class Allocator>
+HandleRequestResult createAssetResponse(http::request<Body, http::basic_fields<Allocator>> const& req,
+                                        StaticFileCache::Asset const& asset) {
+    auto const has_variants = asset.gzip || asset.brotli;
+
+    // Client already has the same content
+    auto const if_none_match = req[http::field::if_none_match];
+
+    if (if_none_match == "*" || if_none_match.find(asset.etag) != beast::string_view::npos) {
+        http::response<http::empty_body> res{http::status::not_modified, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::etag, asset.etag);
+        if (has_variants) {
+            res.set(http::field::vary, "Accept-Encoding");
+        }
+        res.keep_alive(req.keep_alive());
+
+        return {std::move(res)};
+    }
+
+    http::response<SharedBufferBody> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, asset.content_type);
+    res.set(http::field::etag, asset.etag);
+
+    auto const accept_encoding = req[http::field::accept_encoding];
+
+    if (asset.brotli && acceptsEncoding(accept_encoding, "br")) {
+        res.set(http::field::content_encoding, "br");
+        res.body() = asset.brotli;
+    } else if (asset.gzip && acceptsEncoding(accept_encoding, "gzip")) {
+        res.set(http::field::content_encoding, "gzip");
+        res.body() = asset.gzip;
+    } else {
+        res.body() = asset.body;
+    }
+
+    if (has_variants) {
+        res.set(http::field::vary, "Accept-Encoding");
+    }
+
+    res.keep_alive(req.keep_alive());
+    res.prepare_payload();
+
+    return {std::move(res)};
+}
+
 fs::path writeDataToTmpFile(uuids::uuid request_id, fs::path tmp_storage, std::string_view data) {
     auto tmp_file_path = tmp_storage;
     tmp_file_path /= (boost::format("tmp_%1%.txt") % uuids::to_string(request_id)).str();
@@ -66,12 +254,16 @@ fs::path writeDataToTmpFile(uuids::uuid request_id, fs::path tmp_storage, std::s
 
 template <class Body, class Allocator>
 HandleRequestResult handleRequest(std::shared_ptr<SharedState> const& shared_state,
+                                  std::shared_ptr<dto::JsonArena> const& arena,
                                   http::request<Body, http::basic_fields<Allocator>>&& req);
 
 // --------------
 
 HttpSession::HttpSession(net::io_context& ioc, tcp::socket&& socket, std::shared_ptr<SharedState> const& shared_state)
-    : ioc_{ioc}, stream_{std::move(socket)}, shared_state_{shared_state} {}
+    : ioc_{ioc},
+      stream_{std::move(socket)},
+      shared_state_{shared_state},
+      file_transfer_timer_{stream_.get_executor()} {}
 
 void HttpSession::run() {
     net::dispatch(stream_.get_executor(), beast::bind_front_handler(&HttpSession::doRead, shared_from_this()));
@@ -88,8 +280,34 @@ void HttpSession::doRead() {
     // Closes socket if we didn't get
     stream_.expires_after(std::chrono::seconds(30));
 
-    http::async_read(stream_, buffer_, parser_->get(),
-                     beast::bind_front_handler(&HttpSession::onRead, shared_from_this()));
+    // Header is read first, streaming upload body is read with a different parser
+    http::async_read_header(stream_, buffer_, *parser_,
+                            beast::bind_front_handler(&HttpSession::onReadHeader, shared_from_this()));
+}
+
+void HttpSession::onReadHeader(beast::error_code ec, std::size_t) {
+    // Client closed the connection
+    if (ec == http::error::end_of_stream) {
+        stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+        return;
+    }
+
+    if (ec) {
+        return fail(ec, "HttpSession::onReadHeader");
+    }
+
+    auto const& header = parser_->get();
+
+    if (header.method() == http::verb::post && utils::getTargetPath(header.target()) == STREAM_TARGET) {
+        return startStream();
+    }
+
+    if (header.method() == http::verb::post && utils::getTargetPath(header.target()) == BATCH_TARGET) {
+        parser_->body_limit(BATCH_BODY_LIMIT);
+    }
+
+    read_start_ = metrics::Clock::now();
+    http::async_read(stream_, buffer_, *parser_, beast::bind_front_handler(&HttpSession::onRead, shared_from_this()));
 }
 
 void HttpSession::onRead(beast::error_code ec, std::size_t) {
@@ -103,37 +321,211 @@ void HttpSession::onRead(beast::error_code ec, std::size_t) {
         return fail(ec, "HttpSession::onRead");
     }
 
+    metrics::observeSince(metrics::Histogram::http_parse, read_start_);
+    metrics::increment(metrics::Counter::http_requests);
+
     // Upgrade to websocket
     if (websocket::is_upgrade(parser_->get())) {
-        std::make_shared<WebSocketSession>(stream_.release_socket(), shared_state_)->run(parser_->release());
+        std::make_shared<WebSocketSession>(ioc_, stream_.release_socket(), shared_state_)->run(parser_->release());
         return;
     }
 
+    // Arena is reused only when no counting holds the data parsed into it, otherwise new one is created
+    if (parser_->get().method() == http::verb::post) {
+        if (arena_ && arena_.use_count() == 1) {
+            arena_->reset();
+        } else {
+            arena_ = std::make_shared<dto::JsonArena>();
+        }
+    }
+
     // Handle request
-    auto handle_request_result = handleRequest(shared_state_, parser_->release());
+    auto handle_request_result = handleRequest(shared_state_, arena_, parser_->release());
 
-    auto& msg = handle_request_result.msg;
+    if (handle_request_result.msg) {
+        write(std::move(*handle_request_result.msg));
+    }
 
-    bool const keep_alive = msg.keep_alive();
+    if (handle_request_result.file_transfer) {
+        sendFile(std::move(*handle_request_result.file_transfer));
+    }
 
-    auto self = shared_from_this();
+    if (handle_request_result.batch.has_value()) {
+        auto batch = std::make_shared<CountBatchSession>(ioc_, shared_state_, std::move(*handle_request_result.batch));
 
-    beast::async_write(stream_, std::move(msg), [self, keep_alive](beast::error_code ec, std::size_t bytes) {
-        self->onWrite(ec, bytes, keep_alive);
-    });
+        if (handle_request_result.batch_response.has_value()) {
+            // Results are returned in the response, next request is read after it is written
+            batch->run([self = shared_from_this(), res = std::move(*handle_request_result.batch_response)](
+                           json::array results) mutable {
+                json::object response_body;
+                response_body["results"] = std::move(results);
 
-    if (handle_request_result.request_id.has_value() && handle_request_result.tmp_file.has_value()) {
-        // Run counting in a separate process
+                res.body() = json::serialize(response_body);
+                res.prepare_payload();
+
+                net::post(self->stream_.get_executor(),
+                          [self, res = std::move(res)]() mutable { self->write(std::move(res)); });
+            });
+        } else {
+            batch->run([shared_state = shared_state_, user_id = *handle_request_result.user_id,
+                        request_id = *handle_request_result.request_id](json::array results) {
+                shared_state->sendBatch(user_id, request_id, std::move(results));
+            });
+        }
+    }
+
+    if (handle_request_result.request_id.has_value() && handle_request_result.cached_result.has_value()) {
+        // Result is sent the same way as the counted one, after the request is handled
+        net::post(ioc_, [shared_state = shared_state_, user_id = *handle_request_result.user_id,
+                         request_id = *handle_request_result.request_id,
+                         result = *handle_request_result.cached_result] {
+            shared_state->send(user_id, request_id, result);
+        });
+    }
+
+    if (handle_request_result.request_id.has_value() && handle_request_result.payload.has_value()) {
         auto user_id = handle_request_result.user_id.value();
         auto request_id = handle_request_result.request_id.value();
-        auto tmp_file = handle_request_result.tmp_file.value();
+        auto payload = std::move(handle_request_result.payload.value());
+        auto cache_key = std::move(handle_request_result.cache_key);
+
+        auto submitted = true;
+
+        // Request which waited in the queue for too long is answered with an error
+        auto on_expired = [shared_state = shared_state_, user_id, request_id] {
+            shared_state->sendError(user_id, request_id, "Request timed out in the queue");
+        };
+
+        if (shared_state_->getCountMode() == CountMode::in_process) {
+            // Run counting on the compute pool
+            auto session = std::make_shared<CountTaskSession>(ioc_, shared_state_, user_id, request_id, 'I',
+                                                              std::move(payload), std::move(cache_key));
+
+            submitted = shared_state_->getJobScheduler().submit(
+                [session](JobScheduler::Slot slot) { session->run(std::move(slot)); }, std::move(on_expired));
+        } else if (shared_state_->getCountMode() == CountMode::worker_pool) {
+            // Run counting on a persistent worker process
+            std::make_shared<CountWorkerSession>(shared_state_, std::move(user_id), std::move(request_id), 'I',
+                                                 std::move(payload), std::move(cache_key))
+                ->run();
+        } else {
+            // Run counting in a separate process, the process is started on the io context of the session
+            auto session = std::make_shared<CountProcessSession>(ioc_, shared_state_, user_id, request_id, 'I',
+                                                                 std::move(payload), std::move(cache_key));
+
+            submitted = shared_state_->getJobScheduler().submit(
+                [session](JobScheduler::Slot slot) { session->run(std::move(slot)); }, std::move(on_expired));
+        }
 
-        std::make_shared<CountProcessSession>(ioc_, shared_state_, std::move(user_id), std::move(request_id), 'I',
-                                              tmp_file)
-            ->run();
+        // Scheduler filled up after the request was checked, response with the request id is already sent
+        if (!submitted) {
+            metrics::increment(metrics::Counter::jobs_rejected);
+            shared_state_->sendError(user_id, request_id, "Server is busy");
+        }
     }
 }
 
+void HttpSession::startStream() {
+    using namespace response;
+
+    auto const& header = parser_->get();
+
+    if (header[http::field::content_type] != content_type::application_octet_stream) {
+        auto res = createBadRequest(header, "Streaming upload must have application/octet-stream Content-Type");
+        // Body is not read, so the connection cannot be reused
+        res.keep_alive(false);
+        return write(std::move(res));
+    }
+
+    auto const characters = getQueryParameter(header.target(), "characters").value_or(DEFAULT_CHARACTERS);
+
+    if (characters.empty()) {
+        auto res = createBadRequest(header, "Characters must not be empty");
+        res.keep_alive(false);
+        return write(std::move(res));
+    }
+
+    stream_parser_.emplace(std::move(*parser_));
+    parser_.reset();
+
+    // Body is not stored, so its size is not limited
+    stream_parser_->body_limit(boost::none);
+    buffer_.reserve(STREAM_BUFFER_SIZE);
+
+    for (auto const c : characters) {
+        stream_parser_->get().body().characters.insert(c);
+    }
+
+    // Client waits for the confirmation before it sends a large body
+    if (beast::iequals(stream_parser_->get()[http::field::expect], "100-continue")) {
+        auto res = std::make_shared<http::response<http::empty_body>>(http::status::continue_,
+                                                                      stream_parser_->get().version());
+
+        http::async_write(stream_, *res, [self = shared_from_this(), res](beast::error_code ec, std::size_t) {
+            if (ec) {
+                return self->fail(ec, "HttpSession::startStream");
+            }
+
+            self->doReadStream();
+        });
+        return;
+    }
+
+    doReadStream();
+}
+
+void HttpSession::doReadStream() {
+    // Timeout is restarted for every part of the body, so only idle uploads are closed
+    stream_.expires_after(std::chrono::seconds(30));
+
+    http::async_read_some(stream_, buffer_, *stream_parser_,
+                          beast::bind_front_handler(&HttpSession::onReadStream, shared_from_this()));
+}
+
+void HttpSession::onReadStream(beast::error_code ec, std::size_t) {
+    if (ec) {
+        return fail(ec, "HttpSession::onReadStream");
+    }
+
+    if (!stream_parser_->is_done()) {
+        return doReadStream();
+    }
+
+    auto const& req = stream_parser_->get();
+    auto const& body = req.body();
+
+    json::object counts;
+    for (auto const c : body.characters.characters()) {
+        counts[utils::getCharacterKey(c)] = body.counts[static_cast<unsigned char>(c)];
+    }
+
+    json::value response_body{{"size", body.size}, {"counts", std::move(counts)}};
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, content_type::application_json);
+    res.body() = json::serialize(response_body);
+    res.keep_alive(req.keep_alive());
+    res.prepare_payload();
+
+    stream_parser_.reset();
+    buffer_.shrink_to_fit();
+
+    write(std::move(res));
+}
+
+void HttpSession::write(http::message_generator msg) {
+    bool const keep_alive = msg.keep_alive();
+
+    // Response can be written later than the request is read
+    stream_.expires_after(std::chrono::seconds(30));
+
+    beast::async_write(stream_, std::move(msg),
+                       [self = shared_from_this(), keep_alive](beast::error_code ec, std::size_t bytes) {
+                           self->onWrite(ec, bytes, keep_alive);
+                       });
+}
+
 void HttpSession::onWrite(beast::error_code ec, std::size_t, bool keep_alive) {
     if (ec) {
         return fail(ec, "HttpSession::onWrite");
@@ -147,10 +539,91 @@ void HttpSession::onWrite(beast::error_code ec, std::size_t, bool keep_alive) {
     doRead();
 }
 
+void HttpSession::sendFile(FileTransfer transfer) {
+    file_transfer_.emplace(std::move(transfer));
+
+    stream_.expires_after(std::chrono::seconds(30));
+
+    net::async_write(stream_, net::buffer(file_transfer_->header),
+                     beast::bind_front_handler(&HttpSession::onWriteFileHeader, shared_from_this()));
+}
+
+void HttpSession::onWriteFileHeader(beast::error_code ec, std::size_t) {
+    if (ec) {
+        file_transfer_.reset();
+        return fail(ec, "HttpSession::onWriteFileHeader");
+    }
+
+    // sendfile is called directly on the socket, it must not block the io thread
+    stream_.socket().native_non_blocking(true, ec);
+
+    if (ec) {
+        file_transfer_.reset();
+        return fail(ec, "HttpSession::onWriteFileHeader");
+    }
+
+    doSendFile();
+}
+
+void HttpSession::doSendFile() {
+    auto& transfer = *file_transfer_;
+
+    if (transfer.offset < transfer.size) {
+        auto offset = static_cast<off_t>(transfer.offset);
+        auto const count = std::min<std::uint64_t>(transfer.size - transfer.offset, SENDFILE_CHUNK_SIZE);
+
+        auto const sent = ::sendfile(stream_.socket().native_handle(), transfer.file.native_handle(), &offset, count);
+
+        if (sent < 0 && errno != EAGAIN && errno != EINTR) {
+            file_transfer_.reset();
+            return fail(beast::error_code{errno, beast::system_category()}, "HttpSession::doSendFile");
+        }
+
+        // File was truncated while it was sent, response cannot be completed
+        if (sent == 0) {
+            file_transfer_.reset();
+            return fail(net::error::eof, "HttpSession::doSendFile");
+        }
+
+        if (sent > 0) {
+            transfer.offset = static_cast<std::uint64_t>(offset);
+        }
+    }
+
+    if (transfer.offset == transfer.size) {
+        auto const keep_alive = transfer.keep_alive;
+        file_transfer_.reset();
+        return onWrite({}, 0, keep_alive);
+    }
+
+    // Next part is sent when the socket buffer has room, other sessions run in between
+    file_transfer_timer_.expires_after(std::chrono::seconds(30));
+    file_transfer_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (!ec) {
+            self->stream_.socket().cancel(ec);
+        }
+    });
+
+    stream_.socket().async_wait(tcp::socket::wait_write,
+                                beast::bind_front_handler(&HttpSession::onSendFileReady, shared_from_this()));
+}
+
+void HttpSession::onSendFileReady(beast::error_code ec) {
+    file_transfer_timer_.cancel();
+
+    if (ec) {
+        file_transfer_.reset();
+        return fail(ec, "HttpSession::onSendFileReady");
+    }
+
+    doSendFile();
+}
+
 // Utilities DEFINITIONS
 
 template <class Body, class Allocator>
 HandleRequestResult handleRequest(std::shared_ptr<SharedState> const& shared_state_,
+                                  std::shared_ptr<dto::JsonArena> const& arena,
                                   http::request<Body, http::basic_fields<Allocator>>&& req) {
     using namespace response;
 
@@ -159,26 +632,89 @@ HandleRequestResult handleRequest(std::shared_ptr<SharedState> const& shared_sta
     auto const& content_type = req[http::field::content_type];
     auto const& body = req.body();
 
+    // GET: /api/stats
+    if (method == http::verb::get && getTargetPath(target) == STATS_TARGET) {
+        auto const statistics = shared_state_->getResultCache().getStatistics();
+        auto const static_statistics = shared_state_->getStaticFileCache().getStatistics();
+
+        json::value response_body{{"result_cache",
+                                   {{"hits", statistics.hits},
+                                    {"misses", statistics.misses},
+                                    {"evictions", statistics.evictions},
+                                    {"size", statistics.size},
+                                    {"capacity", statistics.capacity}}},
+                                  {"static_cache",
+                                   {{"hits", static_statistics.hits},
+                                    {"misses", static_statistics.misses},
+                                    {"entries", static_statistics.entries},
+                                    {"size", static_statistics.size},
+                                    {"capacity", static_statistics.capacity}}}};
+
+        http::response<http::string_body> res{http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, ::content_type::application_json);
+        res.body() = json::serialize(response_body);
+        res.keep_alive(req.keep_alive());
+        res.prepare_payload();
+
+        return {std::move(res)};
+    }
+    // GET: /metrics
+    else if (method == http::verb::get && getTargetPath(target) == METRICS_TARGET) {
+        auto const statistics = shared_state_->getResultCache().getStatistics();
+        auto const static_statistics = shared_state_->getStaticFileCache().getStatistics();
+
+        auto response_body = metrics::render();
+        metrics::appendMetric(response_body, "chcount_result_cache_hits_total", "counter",
+                              "Requests answered from the result cache", statistics.hits);
+        metrics::appendMetric(response_body, "chcount_result_cache_misses_total", "counter",
+                              "Requests which were counted", statistics.misses);
+        metrics::appendMetric(response_body, "chcount_result_cache_evictions_total", "counter",
+                              "Results removed from the result cache", statistics.evictions);
+        metrics::appendMetric(response_body, "chcount_result_cache_entries", "gauge", "Number of cached results",
+                              statistics.size);
+        metrics::appendMetric(response_body, "chcount_static_cache_hits_total", "counter",
+                              "Documents served from the memory", static_statistics.hits);
+        metrics::appendMetric(response_body, "chcount_static_cache_misses_total", "counter",
+                              "Documents loaded or sent from the disk", static_statistics.misses);
+        metrics::appendMetric(response_body, "chcount_static_cache_entries", "gauge", "Number of cached documents",
+                              static_statistics.entries);
+        metrics::appendMetric(response_body, "chcount_static_cache_bytes", "gauge",
+                              "Size of the cached documents with their variants", static_statistics.size);
+
+        http::response<http::string_body> res{http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, ::content_type::text_prometheus);
+        res.body() = std::move(response_body);
+        res.keep_alive(req.keep_alive());
+        res.prepare_payload();
+
+        return {std::move(res)};
+    }
     // GET: /
-    if (method == http::verb::get) {
+    else if (method == http::verb::get) {
         // Request path must be absolute and not contain "..".
         if (target.empty() || target[0] != '/' || target.find("..") != beast::string_view::npos) {
             return {createBadRequest(req, "Illegal request-target")};
         }
 
-        auto docPath = shared_state_->getDocsPath();
+        auto target_path = std::string{getTargetPath(target)};
 
-        if (target == "/") {
-            docPath /= "index.html";
-        } else {
-            if (target[0] != '/') {
-                docPath /= target.data();
-            } else {
-                docPath += target.data();
-            }
+        if (target_path == "/") {
+            target_path = "/index.html";
+        }
+
+        // Small files are served from the memory, without touching the filesystem
+        if (auto const asset = shared_state_->getStaticFileCache().find(target_path)) {
+            return createAssetResponse(req, *asset);
         }
 
-        if (!fs::exists(docPath)) {
+        auto docPath = shared_state_->getDocsPath();
+        docPath += target_path;
+
+        std::error_code fs_ec;
+
+        if (!fs::is_regular_file(docPath, fs_ec)) {
             return {createNotFound(req, "File not found")};
         }
 
@@ -186,58 +722,124 @@ HandleRequestResult handleRequest(std::shared_ptr<SharedState> const& shared_sta
 
         // Attempt to open the file
         boost::system::error_code ec;
-        http::file_body::value_type response_body;
-        response_body.open(path.c_str(), beast::file_mode::scan, ec);
+        beast::file file;
+        file.open(path.c_str(), beast::file_mode::scan, ec);
 
         // Handle the case where the file doesn't exist
         if (ec == boost::system::errc::no_such_file_or_directory) {
             return {createNotFound(req, req.target())};
         }
 
+        auto const size = ec ? 0 : file.size(ec);
+
         // Handle an unknown error
         if (ec) {
             return {createServerError(req, ec.message())};
         }
 
-        // Cache the size since we need it after the move
-        auto const size = response_body.size();
-
-        // Respond to GET request
-        http::response<http::file_body> res{std::piecewise_construct, std::make_tuple(std::move(response_body)),
-                                            std::make_tuple(http::status::ok, req.version())};
+        // Large file is sent straight from the page cache to the socket, after the response header
+        http::response<http::empty_body> res{http::status::ok, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
         res.set(http::field::content_type, utils::getMimeType(path));
         res.content_length(size);
         res.keep_alive(req.keep_alive());
 
-        return {std::move(res)};
+        std::ostringstream header;
+        header << res.base();
+
+        return HandleRequestResult{HttpSession::FileTransfer{std::move(file), 0, size, req.keep_alive(), header.str()}};
     }
     // METHOD: POST
     // PATH: /api/count
     // CONTENT_TYPE: application/json
-    else if (method == http::verb::post && target == "/api/count" && content_type == content_type::application_json) {
+    else if (method == http::verb::post && getTargetPath(target) == COUNT_TARGET &&
+             content_type == content_type::application_json) {
         try {
-            dto::CountDto countDto = dto::CountDto::parse(body);
+            auto const parse_start = metrics::Clock::now();
+            // Body is moved into the shared DTO, so the data can stay a view into it
+            auto count_dto = std::make_shared<SharedCountDto>(arena, std::move(req.body()));
+            metrics::observeSince(metrics::Histogram::dto_parse, parse_start);
+            auto const& countDto = count_dto->dto;
+
+            // Small data is counted inline and the result is returned in the response, which
+            // is cheaper than any hop of the asynchronous counting
+            if (getQueryParameter(target, "sync") == "1" &&
+                countDto.getData().size() <= shared_state_->getSyncThreshold()) {
+                json::value response_body{{"result", std::to_string(kernel::count(countDto.getData(), 'I'))}};
+
+                http::response<http::string_body> res{http::status::ok, req.version()};
+                res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+                res.set(http::field::content_type, ::content_type::application_json);
+                res.body() = json::serialize(response_body);
+                res.keep_alive(req.keep_alive());
+                res.prepare_payload();
+
+                return {std::move(res)};
+            }
 
-            if (!shared_state_->contains(countDto.getId())) {
+            // Asynchronous counting delivers the result over the WebSocket session
+            if (!countDto.getId()) {
+                return {createBadRequest(req, "Request \"id\" is missing")};
+            }
+
+            if (!shared_state_->contains(*countDto.getId())) {
                 return {createBadRequest(req, "Unknown id")};
             }
 
             auto request_id = shared_state_->createUuid();
 
-            auto tmp_file = writeDataToTmpFile(request_id, shared_state_->getTmpStoragePath(), countDto.getData());
+            auto& result_cache = shared_state_->getResultCache();
+            std::optional<ResultCache::Key> cache_key;
 
-            if (!tmp_file.empty()) {
-                json::value response_body{{"request_id", uuids::to_string(request_id)}};
+            // Repeated data is answered from the cache, without the counting and the temporary file
+            if (result_cache.isEnabled()) {
+                counter::CharacterSet characters;
+                characters.insert('I');
 
-                http::response<http::string_body> res{http::status::ok, req.version()};
-                res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                res.set(http::field::content_type, ::content_type::text_plain);
-                res.body() = json::serialize(response_body);
-                res.keep_alive(req.keep_alive());
-                res.prepare_payload();
+                cache_key = result_cache.makeKey(countDto.getData(), characters);
+
+                if (auto const counts = result_cache.find(*cache_key)) {
+                    HandleRequestResult result{createRequestIdResponse(req, request_id), *countDto.getId(), request_id};
+                    result.cached_result = counts->front();
+                    return result;
+                }
+            }
+
+            // Back-pressure, workers are not able to keep up with the requests
+            if (shared_state_->getCountMode() == CountMode::worker_pool &&
+                shared_state_->getWorkerPool().isSaturated()) {
+                metrics::increment(metrics::Counter::jobs_rejected);
+                return {createServiceUnavailable(req, "Server is busy", WORKER_POOL_RETRY_AFTER)};
+            }
+
+            // Load shedding, request is rejected at once instead of waiting behind the full queue
+            if (shared_state_->getCountMode() != CountMode::worker_pool &&
+                shared_state_->getJobScheduler().isSaturated()) {
+                metrics::increment(metrics::Counter::jobs_rejected);
+                return {createServiceUnavailable(req, "Server is busy",
+                                                 shared_state_->getJobScheduler().getRetryAfter())};
+            }
+
+            // Data is shared with the counter in memory, only large data goes through the temporary storage
+            CountPayload payload;
+
+            if (countDto.getData().size() > shared_state_->getTmpFileThreshold()) {
+                auto const write_start = metrics::Clock::now();
+                payload = writeDataToTmpFile(request_id, shared_state_->getTmpStoragePath(), countDto.getData());
+                metrics::observeSince(metrics::Histogram::tmp_file_write, write_start);
+            } else {
+                // Counter shares the parsed body and the arena, data is not copied
+                count_dto->data = countDto.getData();
+                payload = SharedData{count_dto, &count_dto->data};
+            }
 
-                return {std::move(res), countDto.getId(), request_id, tmp_file};
+            auto const* tmp_file = std::get_if<fs::path>(&payload);
+
+            if (tmp_file == nullptr || !tmp_file->empty()) {
+                HandleRequestResult result{createRequestIdResponse(req, request_id), *countDto.getId(), request_id,
+                                           std::move(payload)};
+                result.cache_key = std::move(cache_key);
+                return result;
             } else {
                 return {createBadRequest(req, "Cannot create tmp file")};
             }
@@ -245,6 +847,77 @@ HandleRequestResult handleRequest(std::shared_ptr<SharedState> const& shared_sta
             return {createBadRequest(req, e.what())};
         }
     }
+    // METHOD: POST
+    // PATH: /api/count/batch
+    // CONTENT_TYPE: application/json
+    else if (method == http::verb::post && getTargetPath(target) == BATCH_TARGET &&
+             content_type == content_type::application_json) {
+        try {
+            auto const parse_start = metrics::Clock::now();
+            auto batch_dto =
+                std::make_shared<SharedCountBatchDto>(arena, dto::CountBatchDto::parse(body, arena->storage()));
+            metrics::observeSince(metrics::Histogram::dto_parse, parse_start);
+            auto const& batchDto = batch_dto->dto;
+
+            if (batchDto.getId() && !shared_state_->contains(*batchDto.getId())) {
+                return {createBadRequest(req, "Unknown id")};
+            }
+
+            // Back-pressure, workers are not able to keep up with the requests
+            if (shared_state_->getCountMode() == CountMode::worker_pool &&
+                shared_state_->getWorkerPool().isSaturated()) {
+                metrics::increment(metrics::Counter::jobs_rejected);
+                return {createServiceUnavailable(req, "Server is busy", WORKER_POOL_RETRY_AFTER)};
+            }
+
+            // Load shedding, batch is admitted by the same scheduler as the single requests
+            if (shared_state_->getCountMode() != CountMode::worker_pool &&
+                shared_state_->getJobScheduler().isSaturated()) {
+                metrics::increment(metrics::Counter::jobs_rejected);
+                return {createServiceUnavailable(req, "Server is busy",
+                                                 shared_state_->getJobScheduler().getRetryAfter())};
+            }
+
+            // Views are kept in the shared DTO, so documents share the parsed body without a copy
+            batch_dto->data.reserve(batchDto.size());
+            std::vector<CountBatchSession::Document> documents;
+            documents.reserve(batchDto.size());
+
+            for (std::size_t i = 0; i < batchDto.size(); ++i) {
+                batch_dto->data.push_back(batchDto.getData(i));
+
+                auto const characters = batchDto.getCharacters(i);
+
+                CountBatchSession::Document document{SharedData{batch_dto, &batch_dto->data.back()}, {}};
+                for (auto const c : characters.empty() ? std::string_view{DEFAULT_CHARACTERS} : characters) {
+                    document.characters.insert(c);
+                }
+
+                documents.push_back(std::move(document));
+            }
+
+            http::response<http::string_body> res{http::status::ok, req.version()};
+            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            res.set(http::field::content_type, ::content_type::application_json);
+            res.keep_alive(req.keep_alive());
+
+            // Without the session results are returned in the response
+            if (!batchDto.getId()) {
+                return {std::move(documents), std::move(res)};
+            }
+
+            auto request_id = shared_state_->createUuid();
+
+            res.body() = json::serialize(json::value{{"request_id", uuids::to_string(request_id)}});
+            res.prepare_payload();
+
+            HandleRequestResult result{std::move(res), *batchDto.getId(), request_id};
+            result.batch = std::move(documents);
+            return result;
+        } catch (std::runtime_error const& e) {
+            return {createBadRequest(req, e.what())};
+        }
+    }
     // Unsupported
     else {
         return {createBadRequest(req, "Unsupported HTTP-method or Content-Type")};
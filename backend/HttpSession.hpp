@@ -1,14 +1,37 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
 #include "Beast.hpp"
+#include "CountingBody.hpp"
+#include "Metrics.hpp"
 #include "Net.hpp"
 
 class SharedState;
 
+namespace dto {
+class JsonArena;
+}
+
 class HttpSession : public std::enable_shared_from_this<HttpSession> {
 public:
     HttpSession(net::io_context& ioc, tcp::socket&& socket, std::shared_ptr<SharedState> const& doc_path);
 
+    /**
+     * @brief File which is sent with sendfile, without reading it into the memory
+     */
+    struct FileTransfer {
+        beast::file file;
+        std::uint64_t offset;
+        std::uint64_t size;
+        bool keep_alive;
+        // Serialized response header, written before the file
+        std::string header;
+    };
+
     /**
      * @brief Run HttpSession and wait for incoming data
      */
@@ -24,10 +47,18 @@ private:
     void fail(beast::error_code ec, char const* what);
 
     /**
-     * @brief Starts the async read from the socket stream
+     * @brief Starts the async read of the request header from the socket stream
      */
     void doRead();
 
+    /**
+     * @brief Handler called after the request header is read.
+     * Starts the streaming upload or reads the whole request body.
+     *
+     * @param ec Error code
+     */
+    void onReadHeader(beast::error_code ec, std::size_t);
+
     /**
      * @brief Handler called after async read is done.
      * Initiates sesstion upgrade to WebSocket is update is requested.
@@ -37,6 +68,31 @@ private:
      */
     void onRead(beast::error_code ec, std::size_t);
 
+    /**
+     * @brief Starts the streaming upload, the body is counted as it arrives and never stored
+     */
+    void startStream();
+
+    /**
+     * @brief Reads the next part of the streaming upload body
+     */
+    void doReadStream();
+
+    /**
+     * @brief Handler called after a part of the streaming upload body is read.
+     * Sends the counts when the whole body is read.
+     *
+     * @param ec Error code
+     */
+    void onReadStream(beast::error_code ec, std::size_t);
+
+    /**
+     * @brief Writes the response and continues with the next request if the connection is kept alive
+     *
+     * @param msg Response
+     */
+    void write(http::message_generator msg);
+
     /**
      * @brief Handler called after async write is done.
      * Initiate new reading from socket stream is conditions are met.
@@ -46,6 +102,32 @@ private:
      */
     void onWrite(beast::error_code ec, std::size_t, bool keep_alive);
 
+    /**
+     * @brief Writes the response header and sends the file after it
+     *
+     * @param transfer File and its response header
+     */
+    void sendFile(FileTransfer transfer);
+
+    /**
+     * @brief Handler called after the response header of the file is written
+     *
+     * @param ec Error code
+     */
+    void onWriteFileHeader(beast::error_code ec, std::size_t);
+
+    /**
+     * @brief Sends the next part of the file straight from the page cache to the socket
+     */
+    void doSendFile();
+
+    /**
+     * @brief Handler called when the socket is ready for the next part of the file
+     *
+     * @param ec Error code
+     */
+    void onSendFileReady(beast::error_code ec);
+
     net::io_context& ioc_;
 
     beast::tcp_stream stream_;
@@ -53,4 +135,17 @@ private:
     beast::flat_buffer buffer_;
 
     std::optional<http::request_parser<http::string_body>> parser_;
+    // Start of the request body read, for the parse latency
+    metrics::Clock::time_point read_start_;
+
+    // Parser of the streaming upload, created from parser_ after the header is read
+    std::optional<http::request_parser<CountingBody>> stream_parser_;
+
+    // Request bodies are parsed into the arena, it's shared with the counting of the parsed data
+    std::shared_ptr<dto::JsonArena> arena_;
+
+    // File which is being sent
+    std::optional<FileTransfer> file_transfer_;
+    // Closes the connection of the client which doesn't read the file
+    net::steady_timer file_transfer_timer_;
 };
@@ -0,0 +1,86 @@
+#include "IoContextPool.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+IoContextPool::IoContextPool(unsigned contexts_count, unsigned threads_per_context, bool pin_threads)
+    : threads_per_context_{std::max(threads_per_context, 1U)}, pin_threads_{pin_threads} {
+    contexts_count = std::max(contexts_count, 1U);
+
+    contexts_.reserve(contexts_count);
+    work_guards_.reserve(contexts_count);
+
+    for (unsigned i = 0; i < contexts_count; ++i) {
+        // Hint of a single thread only avoids waking other threads, the context still locks because handlers
+        // are posted into it from the compute and worker threads, so BOOST_ASIO_CONCURRENCY_HINT_UNSAFE can't be used
+        contexts_.emplace_back(std::make_unique<net::io_context>(static_cast<int>(threads_per_context_)));
+        work_guards_.emplace_back(net::make_work_guard(*contexts_.back()));
+    }
+
+    if (pin_threads_) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            std::cerr << "IoContextPool::IoContextPool: " << std::strerror(errno) << std::endl;
+            pin_threads_ = false;
+            return;
+        }
+
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus_.push_back(cpu);
+            }
+        }
+    }
+}
+
+net::io_context& IoContextPool::getNextIoContext() noexcept {
+    return getIoContext(next_context_.fetch_add(1, std::memory_order_relaxed));
+}
+
+void IoContextPool::run() {
+    auto const threads_count = contexts_.size() * threads_per_context_;
+
+    threads_.reserve(threads_count - 1);
+
+    for (std::size_t i = 0; i + 1 < threads_count; ++i) {
+        threads_.emplace_back([this, i] {
+            pinThread(i);
+            getIoContext(i / threads_per_context_).run();
+        });
+    }
+
+    pinThread(threads_count - 1);
+    contexts_.back()->run();
+
+    for (auto& t : threads_) {
+        t.join();
+    }
+
+    threads_.clear();
+}
+
+void IoContextPool::stop() {
+    for (auto& context : contexts_) {
+        context->stop();
+    }
+}
+
+void IoContextPool::pinThread(std::size_t index) const {
+    if (!pin_threads_ || cpus_.empty()) {
+        return;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpus_[index % cpus_.size()], &cpu_set);
+
+    if (auto const error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set); error != 0) {
+        std::cerr << "IoContextPool::pinThread: " << std::strerror(error) << std::endl;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Net.hpp"
+
+/**
+ * @brief Set of io contexts on which the server runs.
+ *
+ * Shared mode has a single io context which is run by all threads, handlers of a session are
+ * serialized by its strand and can run on any thread. Per core mode has an io context per thread,
+ * every thread is pinned to its own CPU and a session stays on the context (and the CPU) it was
+ * accepted on for its whole lifetime, without a strand.
+ */
+class IoContextPool {
+public:
+    /**
+     * @param contexts_count Number of io contexts, at least 1
+     * @param threads_per_context Number of threads which run every io context, at least 1
+     * @param pin_threads Pin every thread to its own CPU from the CPUs allowed to the process
+     */
+    IoContextPool(unsigned contexts_count, unsigned threads_per_context, bool pin_threads);
+
+    IoContextPool(IoContextPool const&) = delete;
+    IoContextPool& operator=(IoContextPool const&) = delete;
+
+    std::size_t size() const noexcept { return contexts_.size(); }
+
+    /**
+     * @brief Returns true when every io context is run by a single thread, so its handlers don't need a strand
+     */
+    bool isSingleThreaded() const noexcept { return threads_per_context_ == 1; }
+
+    net::io_context& getIoContext(std::size_t index) noexcept { return *contexts_[index % contexts_.size()]; }
+
+    /**
+     * @brief Returns io contexts round robin
+     */
+    net::io_context& getNextIoContext() noexcept;
+
+    /**
+     * @brief Runs all io contexts, calling thread runs the last one. Returns after stop() is called
+     * and all threads are joined.
+     */
+    void run();
+
+    /**
+     * @brief Stops all io contexts, can be called from any thread
+     */
+    void stop();
+
+private:
+    using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+    /**
+     * @brief Pins the calling thread to the CPU
+     *
+     * @param index Thread index, selects the CPU from the CPUs allowed to the process
+     */
+    void pinThread(std::size_t index) const;
+
+    unsigned threads_per_context_;
+    bool pin_threads_;
+    std::vector<std::unique_ptr<net::io_context>> contexts_;
+    // Keeps the contexts without the sessions running
+    std::vector<WorkGuard> work_guards_;
+    std::vector<std::thread> threads_;
+    std::vector<unsigned> cpus_;
+    std::atomic<std::size_t> next_context_{0};
+};
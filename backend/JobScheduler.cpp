@@ -0,0 +1,183 @@
+#include "JobScheduler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Metrics.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Bounds of the Retry-After estimate
+auto constexpr MIN_RETRY_AFTER{std::chrono::seconds{1}};
+auto constexpr MAX_RETRY_AFTER{std::chrono::seconds{60}};
+
+// Weight of the last job in the average running time is 1 / AVERAGE_WEIGHT
+auto constexpr AVERAGE_WEIGHT{8};
+
+JobScheduler::Slot::Slot(JobScheduler& scheduler) noexcept : scheduler_{&scheduler}, started_{Clock::now()} {}
+
+JobScheduler::Slot::~Slot() {
+    if (scheduler_ != nullptr) {
+        scheduler_->release(Clock::now() - started_);
+    }
+}
+
+JobScheduler::Slot::Slot(Slot&& other) noexcept
+    : scheduler_{std::exchange(other.scheduler_, nullptr)}, started_{other.started_} {}
+
+JobScheduler::JobScheduler(net::io_context& ioc, Options const& options)
+    : options_{options}, strand_{net::make_strand(ioc)}, expiry_timer_{strand_} {}
+
+bool JobScheduler::isSaturated() const {
+    std::lock_guard lock{mutex_};
+    return running_ >= options_.concurrency && queue_.size() >= options_.queue_size;
+}
+
+bool JobScheduler::submit(Job job, ExpiredHandler on_expired) {
+    {
+        std::lock_guard lock{mutex_};
+
+        // Queue is not empty only while all slots are taken
+        if (running_ >= options_.concurrency) {
+            if (queue_.size() >= options_.queue_size) {
+                return false;
+            }
+
+            queue_.push_back({std::move(job), std::move(on_expired), Clock::now()});
+            metrics::add(metrics::Gauge::jobs_queued, 1);
+
+            // Timer is idle while the queue is empty, later jobs expire after the front one
+            if (queue_.size() == 1 && options_.queue_timeout.count() > 0) {
+                net::post(strand_, [this] { scheduleExpiry(); });
+            }
+
+            return true;
+        }
+
+        ++running_;
+    }
+
+    metrics::add(metrics::Gauge::jobs_running, 1);
+    job(Slot{*this});
+    return true;
+}
+
+std::chrono::seconds JobScheduler::getRetryAfter() const {
+    std::lock_guard lock{mutex_};
+
+    // Time in which the jobs ahead of the new one are finished
+    auto const jobs_ahead = static_cast<Clock::rep>(queue_.size() + 1);
+    auto const wait = average_duration_ * jobs_ahead / static_cast<Clock::rep>(options_.concurrency);
+
+    return std::clamp(std::chrono::ceil<std::chrono::seconds>(wait), MIN_RETRY_AFTER, MAX_RETRY_AFTER);
+}
+
+void JobScheduler::release(Clock::duration duration) noexcept {
+    // Dropped jobs are notified and destroyed after the lock is released, they can remove their temporary files
+    std::vector<QueuedJob> expired;
+    std::optional<Job> next;
+
+    {
+        std::lock_guard lock{mutex_};
+
+        average_duration_ += (duration - average_duration_) / AVERAGE_WEIGHT;
+
+        // Timer may not have run yet for the jobs which expired just now
+        takeExpired(Clock::now(), expired);
+
+        if (!queue_.empty()) {
+            next = std::move(queue_.front().job);
+            queue_.pop_front();
+        } else {
+            // Slot goes to the next job, otherwise it's free
+            --running_;
+        }
+    }
+
+    notifyExpired(expired);
+
+    if (!next) {
+        metrics::add(metrics::Gauge::jobs_running, -1);
+        return;
+    }
+
+    metrics::add(metrics::Gauge::jobs_queued, -1);
+
+    try {
+        (*next)(Slot{*this});
+    } catch (std::exception const& e) {
+        // Slot of the job is already released
+        std::cerr << "JobScheduler::release: " << e.what() << std::endl;
+    }
+}
+
+void JobScheduler::takeExpired(Clock::time_point now, std::vector<QueuedJob>& expired) {
+    if (options_.queue_timeout.count() == 0) {
+        return;
+    }
+
+    // Jobs are queued in the arrival order, so the expired ones are at the front
+    while (!queue_.empty() && now - queue_.front().queued >= options_.queue_timeout) {
+        expired.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+    }
+}
+
+void JobScheduler::notifyExpired(std::vector<QueuedJob>& expired) noexcept {
+    if (expired.empty()) {
+        return;
+    }
+
+    metrics::add(metrics::Gauge::jobs_queued, -static_cast<std::int64_t>(expired.size()));
+    metrics::increment(metrics::Counter::jobs_expired, expired.size());
+
+    for (auto& queued : expired) {
+        if (!queued.on_expired) {
+            continue;
+        }
+
+        try {
+            queued.on_expired();
+        } catch (std::exception const& e) {
+            std::cerr << "JobScheduler::notifyExpired: " << e.what() << std::endl;
+        }
+    }
+}
+
+void JobScheduler::scheduleExpiry() {
+    Clock::time_point expiry;
+
+    {
+        std::lock_guard lock{mutex_};
+
+        if (queue_.empty()) {
+            return;
+        }
+
+        expiry = queue_.front().queued + options_.queue_timeout;
+    }
+
+    // Pending wait for an earlier front is cancelled
+    expiry_timer_.expires_at(expiry);
+    expiry_timer_.async_wait([this](boost::system::error_code ec) { onExpiryTimer(ec); });
+}
+
+void JobScheduler::onExpiryTimer(boost::system::error_code ec) {
+    if (ec == net::error::operation_aborted) {
+        return;
+    }
+
+    std::vector<QueuedJob> expired;
+
+    {
+        std::lock_guard lock{mutex_};
+        takeExpired(Clock::now(), expired);
+    }
+
+    notifyExpired(expired);
+    scheduleExpiry();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "Net.hpp"
+
+/**
+ * @brief Admission control of the counting jobs.
+ *
+ * At most `concurrency` jobs run at the same time, the others wait in a bounded FIFO queue. Job over the
+ * queue limit is rejected, so the request is answered at once instead of piling up work which the server
+ * cannot finish in time. Job which waits in the queue longer than the queue timeout is dropped by a timer
+ * of the scheduler, so an overload doesn't delay all the jobs behind it, and its expired handler is called.
+ *
+ * Running job holds a Slot, the next queued job is started when the slot is destroyed.
+ */
+class JobScheduler {
+public:
+    struct Options {
+        // Maximum number of running jobs
+        std::size_t concurrency;
+        // Maximum number of jobs waiting for a free slot
+        std::size_t queue_size;
+        // Maximum time for which a job waits in the queue, 0 is unlimited
+        std::chrono::milliseconds queue_timeout;
+        // Maximum running time of a job, enforced by the job itself, 0 is unlimited
+        std::chrono::milliseconds job_timeout;
+    };
+
+    /**
+     * @brief Place of the running job, released when the slot is destroyed
+     */
+    class Slot {
+    public:
+        explicit Slot(JobScheduler& scheduler) noexcept;
+        ~Slot();
+
+        Slot(Slot const&) = delete;
+        Slot& operator=(Slot const&) = delete;
+
+        Slot(Slot&& other) noexcept;
+        Slot& operator=(Slot&&) = delete;
+
+    private:
+        JobScheduler* scheduler_;
+        std::chrono::steady_clock::time_point started_;
+    };
+
+    /**
+     * @brief Starts the job, it must not block, job keeps the slot while it runs
+     */
+    using Job = std::function<void(Slot)>;
+
+    /**
+     * @brief Called instead of the job when it's dropped from the queue, it must not block
+     */
+    using ExpiredHandler = std::function<void()>;
+
+    /**
+     * @param ioc Context which runs the queue timeout timer
+     * @param options Options
+     */
+    JobScheduler(net::io_context& ioc, Options const& options);
+
+    /**
+     * @brief Returns true when new jobs would be rejected
+     */
+    bool isSaturated() const;
+
+    /**
+     * @brief Starts the job if a slot is free, otherwise queues it
+     *
+     * @param job Job
+     * @param on_expired Handler called if the job waits in the queue longer than the queue timeout
+     * @return False if the job is rejected because the queue is full
+     */
+    bool submit(Job job, ExpiredHandler on_expired = {});
+
+    /**
+     * @brief Returns the estimated time after which the rejected job would be accepted, for Retry-After
+     */
+    std::chrono::seconds getRetryAfter() const;
+
+    std::chrono::milliseconds getJobTimeout() const noexcept { return options_.job_timeout; }
+
+private:
+    struct QueuedJob {
+        Job job;
+        ExpiredHandler on_expired;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    /**
+     * @brief Frees the slot of the finished job and starts the next queued job in it
+     *
+     * @param duration Running time of the finished job
+     */
+    void release(std::chrono::steady_clock::duration duration) noexcept;
+
+    /**
+     * @brief Moves the jobs which waited longer than the queue timeout from the front of the queue, called
+     * with the mutex locked
+     */
+    void takeExpired(std::chrono::steady_clock::time_point now, std::vector<QueuedJob>& expired);
+
+    /**
+     * @brief Calls the expired handlers of the dropped jobs, called without the mutex
+     */
+    static void notifyExpired(std::vector<QueuedJob>& expired) noexcept;
+
+    /**
+     * @brief Arms the timer for the expiry of the job at the front of the queue, called on the strand
+     */
+    void scheduleExpiry();
+
+    /**
+     * @brief Drops the expired jobs and arms the timer for the next one, called on the strand
+     *
+     * @param ec Error code
+     */
+    void onExpiryTimer(boost::system::error_code ec);
+
+    Options options_;
+
+    net::strand<net::io_context::executor_type> strand_;
+    // Expires the front of the queue, used only on the strand
+    net::steady_timer expiry_timer_;
+
+    mutable std::mutex mutex_;
+    std::size_t running_{0};
+    std::deque<QueuedJob> queue_;
+    // Moving average of the job running time
+    std::chrono::steady_clock::duration average_duration_{};
+};
@@ -1,12 +1,56 @@
 #include "Listener.hpp"
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <cerrno>
 #include <iostream>
 
 #include "HttpSession.hpp"
+#include "IoContextPool.hpp"
+#include "Metrics.hpp"
 #include "SharedState.hpp"
 
-Listener::Listener(net::io_context& ioc, tcp::endpoint endpoint, std::shared_ptr<SharedState> const& shared_state)
-    : ioc_{ioc}, acceptor_{net::make_strand(ioc)}, shared_state_{shared_state} {
+// Maximum number of the pending connections accepted after a single completion, other acceptors and
+// the sessions of the same io context get their turn after it
+auto constexpr ACCEPT_BATCH_SIZE{64U};
+
+namespace {
+
+/**
+ * @brief Sets integer socket option which Asio doesn't provide publicly (SO_REUSEPORT, TCP_DEFER_ACCEPT)
+ */
+void setSocketOption(tcp::acceptor& acceptor, int level, int name, int value, beast::error_code& ec) {
+    if (::setsockopt(acceptor.native_handle(), level, name, &value, sizeof(value)) == -1) {
+        ec.assign(errno, boost::system::system_category());
+        return;
+    }
+
+    ec = {};
+}
+
+/**
+ * @brief Returns the executor of the session or acceptor on the io context
+ */
+net::any_io_executor makeExecutor(IoContextPool const& io_contexts, net::io_context& ioc) {
+    // Context which is run by a single thread serializes the handlers without a strand
+    if (io_contexts.isSingleThreaded()) {
+        return ioc.get_executor();
+    }
+
+    return net::make_strand(ioc);
+}
+
+}  // namespace
+
+Listener::Listener(IoContextPool& io_contexts, std::optional<std::size_t> context_index, tcp::endpoint endpoint,
+                   Options const& options, std::shared_ptr<SharedState> const& shared_state)
+    : io_contexts_{io_contexts},
+      context_index_{context_index},
+      no_delay_{options.no_delay},
+      acceptor_{makeExecutor(io_contexts, io_contexts.getIoContext(context_index.value_or(0)))},
+      shared_state_{shared_state} {
     beast::error_code ec;
 
     acceptor_.open(endpoint.protocol(), ec);
@@ -21,17 +65,40 @@ Listener::Listener(net::io_context& ioc, tcp::endpoint endpoint, std::shared_ptr
         return;
     }
 
+    if (options.reuse_port) {
+        setSocketOption(acceptor_, SOL_SOCKET, SO_REUSEPORT, 1, ec);
+        if (ec) {
+            fail(ec, "Listener > SetOption");
+            return;
+        }
+    }
+
+    if (options.defer_accept > 0) {
+        setSocketOption(acceptor_, IPPROTO_TCP, TCP_DEFER_ACCEPT, options.defer_accept, ec);
+        if (ec) {
+            fail(ec, "Listener > SetOption");
+            return;
+        }
+    }
+
     acceptor_.bind(endpoint, ec);
     if (ec) {
         fail(ec, "Listener > Bind");
         return;
     }
 
-    acceptor_.listen(net::socket_base::max_listen_connections, ec);
+    acceptor_.listen(options.backlog, ec);
     if (ec) {
         fail(ec, "Listener > Listen");
         return;
     }
+
+    // Pending connections are accepted synchronously until the acceptor would block
+    acceptor_.non_blocking(true, ec);
+    if (ec) {
+        fail(ec, "Listener > NonBlocking");
+        return;
+    }
 }
 
 void Listener::run() {
@@ -40,17 +107,68 @@ void Listener::run() {
 
 void Listener::fail(beast::error_code ec, char const* what) { std::cerr << what << ": " << ec.message() << std::endl; }
 
+net::io_context& Listener::getSessionIoContext() noexcept {
+    if (context_index_) {
+        return io_contexts_.getIoContext(*context_index_);
+    }
+
+    return io_contexts_.getNextIoContext();
+}
+
 void Listener::doAccept() {
-    acceptor_.async_accept(net::make_strand(ioc_), beast::bind_front_handler(&Listener::onAccept, shared_from_this()));
+    auto& ioc = getSessionIoContext();
+
+    acceptor_.async_accept(makeExecutor(io_contexts_, ioc),
+                           [self = shared_from_this(), &ioc](beast::error_code ec, tcp::socket socket) {
+                               self->onAccept(ioc, ec, std::move(socket));
+                           });
 }
 
-void Listener::onAccept(beast::error_code ec, tcp::socket socket) {
+void Listener::onAccept(net::io_context& ioc, beast::error_code ec, tcp::socket socket) {
     if (ec) {
         fail(ec, "Listener::on_accept");
         return;
     } else {
-        std::make_shared<HttpSession>(ioc_, std::move(socket), shared_state_)->run();
+        startSession(ioc, std::move(socket));
+        acceptPending();
     }
 
     doAccept();
 }
+
+void Listener::acceptPending() {
+    for (auto i = ACCEPT_BATCH_SIZE; i > 0; --i) {
+        auto& ioc = getSessionIoContext();
+
+        beast::error_code ec;
+        auto socket = acceptor_.accept(makeExecutor(io_contexts_, ioc), ec);
+
+        if (ec == net::error::would_block || ec == net::error::try_again) {
+            return;
+        }
+
+        if (ec) {
+            return fail(ec, "Listener::acceptPending");
+        }
+
+        startSession(ioc, std::move(socket));
+    }
+}
+
+void Listener::startSession(net::io_context& ioc, tcp::socket socket) {
+    auto const start = metrics::Clock::now();
+
+    if (no_delay_) {
+        beast::error_code ec;
+        socket.set_option(tcp::no_delay(true), ec);
+
+        if (ec) {
+            fail(ec, "Listener::startSession");
+        }
+    }
+
+    std::make_shared<HttpSession>(ioc, std::move(socket), shared_state_)->run();
+
+    metrics::increment(metrics::Counter::connections_accepted);
+    metrics::observeSince(metrics::Histogram::accept, start);
+}
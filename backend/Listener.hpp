@@ -1,24 +1,66 @@
 #pragma once
 
+#include <optional>
+
 #include "Beast.hpp"
 #include "Net.hpp"
 
+class IoContextPool;
 class SharedState;
 
 class Listener : public std::enable_shared_from_this<Listener> {
 public:
-    Listener(net::io_context& ioc, tcp::endpoint endpoint, std::shared_ptr<SharedState> const& shared_state);
+    struct Options {
+        // Open the acceptor with SO_REUSEPORT, so several listeners can share the endpoint
+        bool reuse_port;
+        // Maximum length of the queue of pending connections
+        int backlog;
+        // Seconds for which the connection is not accepted until the client sends data, 0 disables it
+        int defer_accept;
+        // Disable Nagle's algorithm on the accepted connections
+        bool no_delay;
+    };
+
+    /**
+     * @brief Creates the listener whose acceptor runs on the io context of the pool
+     *
+     * @param io_contexts Io contexts of the server
+     * @param context_index Io context of the acceptor and of all its sessions. When empty, acceptor runs on
+     * the first io context and the sessions are spread over all io contexts round robin.
+     * @param endpoint Endpoint on which listener listens
+     * @param options Socket options
+     * @param shared_state Server shared state
+     */
+    Listener(IoContextPool& io_contexts, std::optional<std::size_t> context_index, tcp::endpoint endpoint,
+             Options const& options, std::shared_ptr<SharedState> const& shared_state);
 
     void run();
 
 private:
     void fail(beast::error_code ec, char const* what);
 
+    /**
+     * @brief Returns the io context of the next accepted session
+     */
+    net::io_context& getSessionIoContext() noexcept;
+
     void doAccept();
 
-    void onAccept(beast::error_code ec, tcp::socket socket);
+    void onAccept(net::io_context& ioc, beast::error_code ec, tcp::socket socket);
+
+    /**
+     * @brief Accepts the connections which are already pending without waiting for the next completion
+     */
+    void acceptPending();
+
+    /**
+     * @brief Starts the session of the accepted connection
+     */
+    void startSession(net::io_context& ioc, tcp::socket socket);
 
-    net::io_context& ioc_;
+    IoContextPool& io_contexts_;
+    std::optional<std::size_t> context_index_;
+    bool no_delay_;
     tcp::acceptor acceptor_;
     std::shared_ptr<SharedState> shared_state_;
 };
@@ -0,0 +1,242 @@
+#include "Metrics.hpp"
+
+#include <array>
+#include <atomic>
+#include <boost/format.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+
+namespace {
+
+// Bits of the sub-bucket index, every power of two is split into 2^SUB_BUCKET_BITS buckets
+auto constexpr SUB_BUCKET_BITS{2U};
+auto constexpr SUB_BUCKETS{1U << SUB_BUCKET_BITS};
+
+// Histograms hold values up to 2^MAX_EXPONENT nanoseconds (~18 minutes), larger go to the last bucket
+auto constexpr MAX_EXPONENT{40U};
+auto constexpr BUCKETS_COUNT{(MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + SUB_BUCKETS};
+
+// Exported buckets, from 256 ns to ~69 s, finer buckets would only make the output larger
+auto constexpr MIN_EXPORTED_EXPONENT{8U};
+auto constexpr MAX_EXPORTED_EXPONENT{36U};
+
+struct Description {
+    char const* name;
+    char const* help;
+};
+
+std::array<Description, COUNTERS_COUNT> constexpr COUNTERS{{
+    {"chcount_connections_accepted_total", "Accepted TCP connections"},
+    {"chcount_http_requests_total", "Handled HTTP requests"},
+    {"chcount_ws_messages_sent_total", "WebSocket messages written to the clients"},
+    {"chcount_jobs_rejected_total", "Counting jobs rejected because the server is saturated"},
+    {"chcount_jobs_expired_total", "Counting jobs dropped after waiting in the queue too long"},
+    {"chcount_jobs_timed_out_total", "Counting jobs killed after running too long"},
+}};
+
+std::array<Description, GAUGES_COUNT> constexpr GAUGES{{
+    {"chcount_active_sessions", "Connected WebSocket sessions"},
+    {"chcount_ws_queued_messages", "Messages waiting in the WebSocket session queues"},
+    {"chcount_jobs_running", "Running counting jobs"},
+    {"chcount_jobs_queued", "Counting jobs waiting for a free slot"},
+}};
+
+std::array<Description, HISTOGRAMS_COUNT> constexpr HISTOGRAMS{{
+    {"chcount_accept_seconds", "Socket setup and session start of the accepted connection"},
+    {"chcount_http_parse_seconds", "Reading and parsing of the request body after its header"},
+    {"chcount_dto_parse_seconds", "Parsing of the request JSON"},
+    {"chcount_tmp_file_write_seconds", "Writing of the request data into the temporary storage"},
+    {"chcount_process_spawn_seconds", "Starting of the chcount child process"},
+    {"chcount_count_seconds", "Counting request from its start until the result is available"},
+    {"chcount_ws_delivery_seconds", "WebSocket message from being queued until it is written"},
+}};
+
+/**
+ * @brief Metrics of a single thread. Only the owner thread writes them, atomics make the concurrent
+ * reads of the rendering well defined.
+ */
+struct ThreadMetrics {
+    std::array<std::atomic<std::uint64_t>, COUNTERS_COUNT> counters{};
+    std::array<std::atomic<std::int64_t>, GAUGES_COUNT> gauges{};
+    std::array<std::array<std::atomic<std::uint64_t>, BUCKETS_COUNT>, HISTOGRAMS_COUNT> buckets{};
+    // Sums of the recorded values in nanoseconds
+    std::array<std::atomic<std::uint64_t>, HISTOGRAMS_COUNT> sums{};
+};
+
+/**
+ * @brief Metrics of all threads, metrics of the exited threads are kept
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+};
+
+Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadMetrics& getThreadMetrics() {
+    thread_local ThreadMetrics* thread_metrics = [] {
+        auto& registry = getRegistry();
+        std::lock_guard lock{registry.mutex};
+
+        return registry.threads.emplace_back(std::make_unique<ThreadMetrics>()).get();
+    }();
+
+    return *thread_metrics;
+}
+
+/**
+ * @brief Adds to the value which has no other writer, so no locked instruction is needed
+ */
+template <class T>
+void addRelaxed(std::atomic<T>& value, T delta) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+unsigned getExponent(std::uint64_t value) noexcept { return 63U - static_cast<unsigned>(__builtin_clzll(value | 1)); }
+
+/**
+ * @brief Returns the bucket of the value, bucket i holds values in (lower(i), lower(i + 1)]
+ */
+std::size_t getBucket(std::uint64_t value) noexcept {
+    // Shifted by one, so the exported upper bounds are inclusive as Prometheus expects
+    value = value == 0 ? 0 : value - 1;
+
+    auto const exponent = getExponent(value);
+
+    if (exponent < SUB_BUCKET_BITS) {
+        return static_cast<std::size_t>(value);
+    }
+
+    if (exponent > MAX_EXPONENT) {
+        return BUCKETS_COUNT - 1;
+    }
+
+    auto const sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+/**
+ * @brief Returns the lowest value of the bucket before the shift by one, the upper bound of the bucket before it
+ */
+std::uint64_t getLowerBound(std::size_t bucket) noexcept {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    auto const exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    auto const sub_bucket = bucket % SUB_BUCKETS;
+
+    return (std::uint64_t{1} << exponent) + (sub_bucket << (exponent - SUB_BUCKET_BITS));
+}
+
+void appendHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+}  // namespace
+
+void increment(Counter counter, std::uint64_t value) noexcept {
+    addRelaxed(getThreadMetrics().counters[static_cast<std::size_t>(counter)], value);
+}
+
+void add(Gauge gauge, std::int64_t value) noexcept {
+    addRelaxed(getThreadMetrics().gauges[static_cast<std::size_t>(gauge)], value);
+}
+
+void observe(Histogram histogram, Clock::duration duration) noexcept {
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    auto const value = static_cast<std::uint64_t>(ns < 0 ? 0 : ns);
+
+    auto& thread_metrics = getThreadMetrics();
+    auto const index = static_cast<std::size_t>(histogram);
+
+    addRelaxed(thread_metrics.buckets[index][getBucket(value)], std::uint64_t{1});
+    addRelaxed(thread_metrics.sums[index], value);
+}
+
+std::string render() {
+    std::array<std::uint64_t, COUNTERS_COUNT> counters{};
+    std::array<std::int64_t, GAUGES_COUNT> gauges{};
+    std::array<std::array<std::uint64_t, BUCKETS_COUNT>, HISTOGRAMS_COUNT> buckets{};
+    std::array<std::uint64_t, HISTOGRAMS_COUNT> sums{};
+
+    {
+        auto& registry = getRegistry();
+        std::lock_guard lock{registry.mutex};
+
+        for (auto const& thread_metrics : registry.threads) {
+            for (std::size_t i = 0; i < COUNTERS_COUNT; ++i) {
+                counters[i] += thread_metrics->counters[i].load(std::memory_order_relaxed);
+            }
+
+            for (std::size_t i = 0; i < GAUGES_COUNT; ++i) {
+                gauges[i] += thread_metrics->gauges[i].load(std::memory_order_relaxed);
+            }
+
+            for (std::size_t i = 0; i < HISTOGRAMS_COUNT; ++i) {
+                for (std::size_t j = 0; j < BUCKETS_COUNT; ++j) {
+                    buckets[i][j] += thread_metrics->buckets[i][j].load(std::memory_order_relaxed);
+                }
+
+                sums[i] += thread_metrics->sums[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string out;
+
+    for (std::size_t i = 0; i < COUNTERS_COUNT; ++i) {
+        appendMetric(out, COUNTERS[i].name, "counter", COUNTERS[i].help, counters[i]);
+    }
+
+    for (std::size_t i = 0; i < GAUGES_COUNT; ++i) {
+        appendHeader(out, GAUGES[i].name, "gauge", GAUGES[i].help);
+        out.append(GAUGES[i].name).append(" ").append(std::to_string(gauges[i])).append("\n");
+    }
+
+    for (std::size_t i = 0; i < HISTOGRAMS_COUNT; ++i) {
+        std::string_view const name = HISTOGRAMS[i].name;
+        appendHeader(out, name, "histogram", HISTOGRAMS[i].help);
+
+        std::uint64_t cumulative = 0;
+
+        for (std::size_t j = 0; j + 1 < BUCKETS_COUNT; ++j) {
+            cumulative += buckets[i][j];
+
+            auto const upper_bound = getLowerBound(j + 1);
+            auto const exponent = getExponent(upper_bound);
+
+            if (exponent < MIN_EXPORTED_EXPONENT || exponent >= MAX_EXPORTED_EXPONENT) {
+                continue;
+            }
+
+            out.append(name).append("_bucket{le=\"");
+            out.append((boost::format("%g") % (static_cast<double>(upper_bound) / 1e9)).str());
+            out.append("\"} ").append(std::to_string(cumulative)).append("\n");
+        }
+
+        cumulative += buckets[i][BUCKETS_COUNT - 1];
+
+        out.append(name).append("_bucket{le=\"+Inf\"} ").append(std::to_string(cumulative)).append("\n");
+        out.append(name).append("_sum ");
+        out.append((boost::format("%.9f") % (static_cast<double>(sums[i]) / 1e9)).str()).append("\n");
+        out.append(name).append("_count ").append(std::to_string(cumulative)).append("\n");
+    }
+
+    return out;
+}
+
+void appendMetric(std::string& out, std::string_view name, std::string_view type, std::string_view help,
+                  std::uint64_t value) {
+    appendHeader(out, name, type, help);
+    out.append(name).append(" ").append(std::to_string(value)).append("\n");
+}
+
+}  // namespace metrics
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Server metrics in the Prometheus text format.
+ *
+ * Every thread updates only its own block of counters and histograms, allocated on its first update. Block
+ * has a single writer, so updates are plain relaxed loads and stores without the locked instructions and
+ * without the cache lines shared between threads. Blocks are summed when the metrics are rendered.
+ *
+ * Histograms are HDR-style, every power of two of nanoseconds is split into 4 buckets, so a recorded value
+ * is off by at most 25 %.
+ */
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Counter {
+    // Accepted TCP connections
+    connections_accepted,
+    // Handled HTTP requests
+    http_requests,
+    // WebSocket messages written to the clients
+    ws_messages_sent,
+    // Counting jobs rejected because the server is saturated
+    jobs_rejected,
+    // Counting jobs dropped after waiting in the queue too long
+    jobs_expired,
+    // Counting jobs killed after running too long
+    jobs_timed_out
+};
+
+/**
+ * @brief Gauges are sums of the changes from all threads
+ */
+enum class Gauge {
+    // Joined WebSocket sessions
+    active_sessions,
+    // Messages in the WebSocket session queues
+    ws_queued_messages,
+    // Running counting jobs
+    jobs_running,
+    // Counting jobs waiting for a free slot
+    jobs_queued
+};
+
+enum class Histogram {
+    // Socket setup and session start of the accepted connection
+    accept,
+    // Reading and parsing of the request body, after the header is parsed
+    http_parse,
+    // Parsing of the request JSON into the DTO
+    dto_parse,
+    // Writing of the request data into the temporary storage
+    tmp_file_write,
+    // Starting of the chcount child process
+    process_spawn,
+    // Counting request from its start until the result is available
+    count,
+    // WebSocket message from being queued until it is written
+    ws_delivery
+};
+
+auto constexpr COUNTERS_COUNT{static_cast<std::size_t>(Counter::jobs_timed_out) + 1};
+auto constexpr GAUGES_COUNT{static_cast<std::size_t>(Gauge::jobs_queued) + 1};
+auto constexpr HISTOGRAMS_COUNT{static_cast<std::size_t>(Histogram::ws_delivery) + 1};
+
+void increment(Counter counter, std::uint64_t value = 1) noexcept;
+
+void add(Gauge gauge, std::int64_t value) noexcept;
+
+void observe(Histogram histogram, Clock::duration duration) noexcept;
+
+/**
+ * @brief Records the time elapsed from the start
+ */
+inline void observeSince(Histogram histogram, Clock::time_point start) noexcept {
+    observe(histogram, Clock::now() - start);
+}
+
+/**
+ * @brief Returns all metrics in the Prometheus text format
+ */
+std::string render();
+
+/**
+ * @brief Appends the metric with a single value in the Prometheus text format
+ *
+ * @param out Output
+ * @param name Metric name
+ * @param type Metric type, counter or gauge
+ * @param help Metric description
+ * @param value Metric value
+ */
+void appendMetric(std::string& out, std::string_view name, std::string_view type, std::string_view help,
+                  std::uint64_t value);
+
+}  // namespace metrics
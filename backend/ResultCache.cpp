@@ -0,0 +1,70 @@
+#include "ResultCache.hpp"
+
+ResultCache::Key ResultCache::makeKey(std::string_view data, counter::CharacterSet const& characters) const {
+    auto const& chars = characters.characters();
+    return {utils::keyedHash128(data, hash_key_), data.size(), std::string(chars.cbegin(), chars.cend())};
+}
+
+ResultCache::ResultCache(std::size_t capacity)
+    : hash_key_{utils::createHashKey()},
+      capacity_{capacity},
+      shard_capacity_{(capacity + SHARDS_COUNT - 1) / SHARDS_COUNT} {}
+
+std::optional<ResultCache::Counts> ResultCache::find(Key const& key) {
+    if (!isEnabled()) {
+        return {};
+    }
+
+    auto& shard = getShard(key);
+    std::lock_guard lock{shard.mutex};
+
+    auto const it = shard.index.find(key);
+
+    if (it == shard.index.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+
+    return it->second->second;
+}
+
+void ResultCache::insert(Key key, Counts counts) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    auto& shard = getShard(key);
+    std::lock_guard lock{shard.mutex};
+
+    // Same data could be counted concurrently by several requests
+    if (auto const it = shard.index.find(key); it != shard.index.end()) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    if (shard.entries.size() >= shard_capacity_) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    shard.entries.emplace_front(std::move(key), std::move(counts));
+    shard.index.emplace(shard.entries.front().first, shard.entries.begin());
+
+    size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ResultCache::Statistics ResultCache::getStatistics() const noexcept {
+    return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed),
+            evictions_.load(std::memory_order_relaxed), size_.load(std::memory_order_relaxed), capacity_};
+}
+
+ResultCache::Shard& ResultCache::getShard(Key const& key) noexcept {
+    // Low bits select the bucket of the shard map, high bits select the shard
+    return shards_[(key.hash[0] >> 56) % SHARDS_COUNT];
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Counter.hpp"
+#include "utils/Hash.hpp"
+
+/**
+ * @brief Bounded LRU cache of the counting results, keyed by the content hash of the data and
+ * the counted characters. Cache is split into shards with their own lock and LRU list, so
+ * lookups of different keys rarely contend.
+ *
+ * Data itself is not stored. Content hash is a 128-bit keyed hash with a random key of the cache,
+ * so a client cannot craft data which collides with the data of another client.
+ */
+class ResultCache {
+public:
+    // Counts of the characters in ascending unsigned byte order
+    using Counts = std::vector<std::uint64_t>;
+
+    struct Key {
+        utils::Digest128 hash;
+        std::uint64_t size;
+        std::string characters;
+
+        bool operator==(Key const& other) const noexcept {
+            return hash == other.hash && size == other.size && characters == other.characters;
+        }
+    };
+
+    struct Statistics {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::size_t size;
+        std::size_t capacity;
+    };
+
+    /**
+     * @brief Returns the key of the data and the characters
+     */
+    Key makeKey(std::string_view data, counter::CharacterSet const& characters) const;
+
+    /**
+     * @param capacity Maximum number of results, 0 disables the cache
+     */
+    explicit ResultCache(std::size_t capacity);
+
+    bool isEnabled() const noexcept { return capacity_ != 0; }
+
+    /**
+     * @brief Returns the cached result and marks it as recently used
+     */
+    std::optional<Counts> find(Key const& key);
+
+    /**
+     * @brief Inserts the result, least recently used result of the shard is evicted when the shard is full
+     */
+    void insert(Key key, Counts counts);
+
+    Statistics getStatistics() const noexcept;
+
+private:
+    struct KeyHash {
+        std::size_t operator()(Key const& key) const noexcept { return static_cast<std::size_t>(key.hash[0]); }
+    };
+
+    struct Shard {
+        using Entry = std::pair<Key, Counts>;
+
+        std::mutex mutex;
+        // Most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    };
+
+    static std::size_t constexpr SHARDS_COUNT{16};
+
+    Shard& getShard(Key const& key) noexcept;
+
+    // Key of the content hash, generated per process
+    utils::HashKey hash_key_;
+    std::size_t capacity_;
+    std::size_t shard_capacity_;
+    std::array<Shard, SHARDS_COUNT> shards_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::size_t> size_{0};
+};
@@ -0,0 +1,53 @@
+#include "SessionRegistry.hpp"
+
+#include <mutex>
+
+#include "WebSocketSession.hpp"
+
+namespace uuids = boost::uuids;
+
+bool SessionRegistry::contains(uuids::uuid const& session_id) const {
+    auto const& shard = getShard(session_id);
+    std::shared_lock lock{shard.mutex};
+
+    return shard.sessions.count(session_id) != 0;
+}
+
+std::shared_ptr<WebSocketSession> SessionRegistry::find(uuids::uuid const& session_id) const {
+    auto const& shard = getShard(session_id);
+    std::shared_lock lock{shard.mutex};
+
+    auto const it = shard.sessions.find(session_id);
+
+    if (it == shard.sessions.end()) {
+        return {};
+    }
+
+    // Session whose destructor is waiting for the lock is already expired
+    return it->second->weak_from_this().lock();
+}
+
+void SessionRegistry::insert(WebSocketSession* ws) {
+    auto const id = ws->getId();
+    auto& shard = getShard(id);
+    std::unique_lock lock{shard.mutex};
+
+    shard.sessions.emplace(id, ws);
+}
+
+bool SessionRegistry::erase(WebSocketSession* ws) {
+    auto const id = ws->getId();
+    auto& shard = getShard(id);
+    std::unique_lock lock{shard.mutex};
+
+    return shard.sessions.erase(id) != 0;
+}
+
+SessionRegistry::Shard& SessionRegistry::getShard(uuids::uuid const& session_id) noexcept {
+    // Ids are random, so any byte distributes the sessions evenly
+    return shards_[session_id.data[0] % SHARDS_COUNT];
+}
+
+SessionRegistry::Shard const& SessionRegistry::getShard(uuids::uuid const& session_id) const noexcept {
+    return shards_[session_id.data[0] % SHARDS_COUNT];
+}
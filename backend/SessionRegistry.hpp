@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <boost/container_hash/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+class WebSocketSession;
+
+/**
+ * @brief Registry of the connected WebSocket sessions by their id.
+ *
+ * Sessions are split into shards by the id, every shard has its own reader-writer lock. Lookups take only
+ * the shared lock of a single shard, so concurrent sends and lookups don't serialize with each other, and
+ * joins and leaves block only the lookups of the same shard.
+ *
+ * Entries are raw pointers, which are removed by the session destructor. Pointer is dereferenced only under
+ * the shard lock, where the session cannot finish its destruction, and it is turned into a weak pointer there.
+ */
+class SessionRegistry {
+public:
+    bool contains(boost::uuids::uuid const& session_id) const;
+
+    /**
+     * @brief Returns the session or empty pointer if the session is not registered or is being destroyed
+     */
+    std::shared_ptr<WebSocketSession> find(boost::uuids::uuid const& session_id) const;
+
+    void insert(WebSocketSession* ws);
+    /**
+     * @brief Removes the session, returns false if the session is not registered
+     */
+    bool erase(WebSocketSession* ws);
+
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<boost::uuids::uuid, WebSocketSession*, boost::hash<boost::uuids::uuid>> sessions;
+    };
+
+    static std::size_t constexpr SHARDS_COUNT{64};
+
+    Shard& getShard(boost::uuids::uuid const& session_id) noexcept;
+    Shard const& getShard(boost::uuids::uuid const& session_id) const noexcept;
+
+    std::array<Shard, SHARDS_COUNT> shards_;
+};
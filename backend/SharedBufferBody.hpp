@@ -0,0 +1,44 @@
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "Beast.hpp"
+#include "Net.hpp"
+
+/**
+ * @brief HTTP response body which refers to an immutable shared buffer. Many responses
+ * share the same buffer, it is written to the socket without a copy.
+ */
+struct SharedBufferBody {
+    using value_type = std::shared_ptr<std::string const>;
+
+    static std::uint64_t size(value_type const& body) noexcept { return body ? body->size() : 0; }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(http::header<isRequest, Fields> const&, value_type const& body) : body_{body} {}
+
+        void init(beast::error_code& ec) { ec = {}; }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+
+            if (!body_ || body_->empty()) {
+                return boost::none;
+            }
+
+            // Whole body in a single buffer, there is no more data after it
+            return {{net::const_buffer{body_->data(), body_->size()}, false}};
+        }
+
+    private:
+        value_type const& body_;
+    };
+};
@@ -2,55 +2,118 @@
 
 #include <boost/json/serialize.hpp>
 #include <boost/json/value.hpp>
+#include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <iostream>
 
+#include "Metrics.hpp"
+#include "ResultCache.hpp"
+#include "StaticFileCache.hpp"
+#include "ThreadPool.hpp"
 #include "WebSocketSession.hpp"
+#include "WorkerPool.hpp"
 
 namespace fs = std::filesystem;
 namespace uuids = boost::uuids;
 namespace json = boost::json;
 
-SharedState::SharedState(fs::path docs, fs::path tmp_storage, fs::path chcount_executable)
-    : docs_{std::move(docs)},
-      tmp_storage_{std::move(tmp_storage)},
-      chcount_executable_{std::move(chcount_executable)} {}
+SharedState::SharedState(net::io_context& ioc, Options const& options)
+    : docs_{options.docs},
+      tmp_storage_{options.tmp_storage},
+      chcount_executable_{options.chcount_executable},
+      count_mode_{options.count_mode},
+      tmp_file_threshold_{options.tmp_file_threshold},
+      sync_threshold_{options.sync_threshold},
+      ws_flush_window_{options.ws_flush_window},
+      ws_deflate_{options.ws_deflate},
+      job_scheduler_{std::make_unique<JobScheduler>(ioc, options.job_options)},
+      result_cache_{std::make_unique<ResultCache>(options.result_cache_size)},
+      static_file_cache_{
+          std::make_unique<StaticFileCache>(ioc, docs_, options.static_cache_file_limit, options.static_cache_size)} {
+    if (count_mode_ != CountMode::worker_pool) {
+        compute_pool_ = std::make_unique<ThreadPool>(options.compute_threads_count);
+    } else {
+        worker_pool_ = std::make_shared<WorkerPool>(ioc, chcount_executable_, options.workers_count,
+                                                    options.worker_queue_size);
+        worker_pool_->start();
+    }
+
+    static_file_cache_->start();
+}
 
-uuids::uuid SharedState::createUuid() noexcept { return random_gen_(); }
+// Defined here, where ThreadPool, WorkerPool and the caches are complete types
+SharedState::~SharedState() = default;
 
-bool SharedState::contains(boost::uuids::uuid session_id) {
-    std::lock_guard lock{mutex_};
-    return (sessions_.count(session_id) != 0);
+uuids::uuid SharedState::createUuid() noexcept {
+    // Generator is not thread safe, every io context thread has its own
+    thread_local uuids::random_generator random_gen;
+    return random_gen();
 }
 
-void SharedState::send(uuids::uuid user_id, uuids::uuid request_id, std::string msg) {
-    json::value value{{"type", "result"}, {"data", {{"request_id", uuids::to_string(request_id)}, {"result", msg}}}};
+bool SharedState::contains(boost::uuids::uuid session_id) { return sessions_.contains(session_id); }
 
-    auto const& ss = std::make_shared<std::string const>(json::serialize(value));
+void SharedState::send(uuids::uuid user_id, uuids::uuid request_id, std::uint64_t result) {
+    auto ws = findSession(user_id);
 
-    if (!contains(user_id)) {
-        std::cerr << "SharedState::send: Session with \"" << uuids::to_string(user_id) << "\" doesn't exists"
-                  << std::endl;
+    if (!ws) {
+        return;
+    }
+
+    if (ws->isBinary()) {
+        ws->send(std::make_shared<std::string const>(WebSocketSession::encodeBinaryResult(request_id, result)), true);
         return;
     }
 
-    std::weak_ptr<WebSocketSession> ws;
-    {
-        std::lock_guard lock{mutex_};
-        ws = sessions_[user_id]->weak_from_this();
+    json::value value{{"type", "result"},
+                      {"data", {{"request_id", uuids::to_string(request_id)}, {"result", std::to_string(result)}}}};
+
+    ws->send(std::make_shared<std::string const>(json::serialize(value)));
+}
+
+void SharedState::sendError(uuids::uuid user_id, uuids::uuid request_id, std::string_view error) {
+    json::value value{{"type", "result"}, {"data", {{"request_id", uuids::to_string(request_id)}, {"error", error}}}};
+
+    deliver(user_id, std::make_shared<std::string const>(json::serialize(value)));
+}
+
+void SharedState::sendBatch(uuids::uuid user_id, uuids::uuid request_id, json::array results) {
+    // Results are moved into the message, initializer list would copy them
+    json::object value;
+    value["type"] = "batch_result";
+
+    auto& data = value["data"].emplace_object();
+    data["request_id"] = uuids::to_string(request_id);
+    data["results"] = std::move(results);
+
+    deliver(user_id, std::make_shared<std::string const>(json::serialize(value)));
+}
+
+void SharedState::deliver(uuids::uuid user_id, std::shared_ptr<std::string const> const& msg) {
+    if (auto ws = findSession(user_id)) {
+        ws->send(msg);
     }
+}
+
+std::shared_ptr<WebSocketSession> SharedState::findSession(uuids::uuid user_id) {
+    // Session is looked up once, it can leave between a separate check and the lookup
+    auto ws = sessions_.find(user_id);
 
-    if (auto sp = ws.lock()) {
-        sp->send(ss);
+    if (!ws) {
+        std::cerr << "SharedState::send: Session with \"" << uuids::to_string(user_id) << "\" doesn't exists"
+                  << std::endl;
     }
+
+    return ws;
 }
 
 void SharedState::join(WebSocketSession* ws) {
-    std::lock_guard lock{mutex_};
-    sessions_.emplace(std::make_pair(ws->getId(), ws));
+    sessions_.insert(ws);
+    metrics::add(metrics::Gauge::active_sessions, 1);
 }
 
 void SharedState::leave(WebSocketSession* ws) {
-    std::lock_guard lock{mutex_};
-    sessions_.erase(ws->getId());
+    // Session which failed before the join is not registered
+    if (sessions_.erase(ws)) {
+        metrics::add(metrics::Gauge::active_sessions, -1);
+    }
 }
@@ -1,39 +1,172 @@
 #pragma once
 
-#include <boost/container_hash/hash.hpp>
-#include <boost/uuid/random_generator.hpp>
+#include <boost/json/array.hpp>
 #include <boost/uuid/uuid.hpp>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
-#include <mutex>
-#include <unordered_map>
+#include <memory>
+#include <string_view>
 
+#include "JobScheduler.hpp"
+#include "Net.hpp"
+#include "SessionRegistry.hpp"
+
+class ResultCache;
+class StaticFileCache;
+class ThreadPool;
 class WebSocketSession;
+class WorkerPool;
+
+/**
+ * @brief How the counting requests are executed
+ */
+enum class CountMode {
+    // Every request spawns chcount child process
+    process,
+    // Requests are counted on the compute thread pool inside the server
+    in_process,
+    // Requests are sent to the pool of persistent chcount worker processes
+    worker_pool
+};
 
 class SharedState {
 public:
-    explicit SharedState(std::filesystem::path docs, std::filesystem::path tmp_storage,
-                         std::filesystem::path chcount_executable);
+    struct Options {
+        // Served documents location
+        std::filesystem::path docs;
+        // Directory of the temporary files of the large requests
+        std::filesystem::path tmp_storage;
+        // Chcount executable, not needed in CountMode::in_process
+        std::filesystem::path chcount_executable;
+        CountMode count_mode;
+        // Number of threads of the compute pool, used outside of CountMode::worker_pool
+        unsigned compute_threads_count;
+        // Request data size above which data is passed to the counter through a temporary file
+        std::size_t tmp_file_threshold;
+        // Number of chcount worker processes in CountMode::worker_pool
+        unsigned workers_count;
+        // Number of requests which wait for a free worker
+        std::size_t worker_queue_size;
+        // Maximum request data size which is counted synchronously on request
+        std::size_t sync_threshold;
+        // Maximum number of cached counting results, 0 disables the cache
+        std::size_t result_cache_size;
+        // Time for which the WebSocket message waits for the others, 0 sends it immediately
+        std::chrono::microseconds ws_flush_window;
+        // Offer permessage-deflate compression to the WebSocket clients
+        bool ws_deflate;
+        // Maximum size of the cached documents, 0 disables the cache
+        std::size_t static_cache_size;
+        // Maximum size of a cached document
+        std::size_t static_cache_file_limit;
+        // Admission control of the counting jobs
+        JobScheduler::Options job_options;
+    };
+
+    SharedState(net::io_context& ioc, Options const& options);
+
+    ~SharedState();
 
     boost::uuids::uuid createUuid() noexcept;
 
     std::filesystem::path getDocsPath() const noexcept { return docs_; }
     std::filesystem::path getTmpStoragePath() const noexcept { return tmp_storage_; }
     std::filesystem::path getChcountExecutablePath() const noexcept { return chcount_executable_; }
+    CountMode getCountMode() const noexcept { return count_mode_; }
+
+    /**
+     * @brief Returns the size in bytes above which the request data is written to the temporary storage
+     * instead of being passed to the counter in memory
+     */
+    std::size_t getTmpFileThreshold() const noexcept { return tmp_file_threshold_; }
+
+    /**
+     * @brief Returns the maximum request data size in bytes which is counted synchronously on request
+     */
+    std::size_t getSyncThreshold() const noexcept { return sync_threshold_; }
+
+    /**
+     * @brief Returns the pool on which in-process counting and batches run.
+     * Pool doesn't exist in CountMode::worker_pool, where all counting is done by the workers.
+     */
+    ThreadPool& getComputePool() noexcept { return *compute_pool_; }
+
+    /**
+     * @brief Returns the pool of chcount worker processes. Pool exists only in CountMode::worker_pool.
+     */
+    WorkerPool& getWorkerPool() noexcept { return *worker_pool_; }
+
+    /**
+     * @brief Returns the admission control of the counting in the child processes and on the compute pool.
+     * Worker pool has its own queue.
+     */
+    JobScheduler& getJobScheduler() noexcept { return *job_scheduler_; }
+
+    /**
+     * @brief Returns the cache of the counting results, shared by all counting modes
+     */
+    ResultCache& getResultCache() noexcept { return *result_cache_; }
+
+    /**
+     * @brief Returns the in-memory cache of the served documents
+     */
+    StaticFileCache& getStaticFileCache() noexcept { return *static_file_cache_; }
+
+    /**
+     * @brief Returns the time for which the WebSocket message waits for the others, so they are sent
+     * in a single frame. Applies only to the sessions which asked for the coalescing.
+     */
+    std::chrono::microseconds getWebSocketFlushWindow() const noexcept { return ws_flush_window_; }
+
+    /**
+     * @brief Returns true if the WebSocket sessions offer the permessage-deflate compression
+     */
+    bool isWebSocketDeflateEnabled() const noexcept { return ws_deflate_; }
 
     bool contains(boost::uuids::uuid session_id);
 
-    void send(boost::uuids::uuid user_id, boost::uuids::uuid request_id, std::string result);
+    /**
+     * @brief Sends the counting result, as JSON message or as binary record if the session negotiated it
+     */
+    void send(boost::uuids::uuid user_id, boost::uuids::uuid request_id, std::uint64_t result);
+
+    /**
+     * @brief Sends the result of the request which cannot be counted, always as JSON message
+     */
+    void sendError(boost::uuids::uuid user_id, boost::uuids::uuid request_id, std::string_view error);
+
+    /**
+     * @brief Sends the results of all batch documents in a single message
+     */
+    void sendBatch(boost::uuids::uuid user_id, boost::uuids::uuid request_id, boost::json::array results);
 
     void join(WebSocketSession* ws);
     void leave(WebSocketSession* ws);
 
 private:
-    std::mutex mutex_;
+    /**
+     * @brief Sends the message to the WebSocket session of the user
+     */
+    void deliver(boost::uuids::uuid user_id, std::shared_ptr<std::string const> const& msg);
+
+    /**
+     * @brief Returns the session of the user or empty pointer if the user is not connected
+     */
+    std::shared_ptr<WebSocketSession> findSession(boost::uuids::uuid user_id);
 
     std::filesystem::path docs_;
     std::filesystem::path tmp_storage_;
     std::filesystem::path chcount_executable_;
-    boost::uuids::random_generator random_gen_;
-
-    std::unordered_map<boost::uuids::uuid, WebSocketSession*, boost::hash<boost::uuids::uuid>> sessions_;
+    CountMode count_mode_;
+    std::size_t tmp_file_threshold_;
+    std::size_t sync_threshold_;
+    std::chrono::microseconds ws_flush_window_;
+    bool ws_deflate_;
+    std::unique_ptr<ThreadPool> compute_pool_;
+    std::shared_ptr<WorkerPool> worker_pool_;
+    std::unique_ptr<JobScheduler> job_scheduler_;
+    std::unique_ptr<ResultCache> result_cache_;
+    std::unique_ptr<StaticFileCache> static_file_cache_;
+    SessionRegistry sessions_;
 };
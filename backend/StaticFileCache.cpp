@@ -0,0 +1,311 @@
+#include "StaticFileCache.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <boost/format.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "utils/Gzip.hpp"
+#include "utils/Hash.hpp"
+#include "utils/MimeType.hpp"
+
+namespace fs = std::filesystem;
+
+// Files smaller than this are not compressed, headers of the compressed response cost more than it saves
+auto constexpr MIN_COMPRESSED_SIZE{256U};
+
+auto constexpr WATCH_MASK{IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                          IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF};
+
+namespace {
+
+/**
+ * @brief Returns the content of the file, empty if the file cannot be read
+ */
+std::shared_ptr<std::string const> readFile(fs::path const& path) {
+    std::ifstream fin{path, std::ios::binary};
+
+    if (!fin.is_open()) {
+        return {};
+    }
+
+    std::ostringstream content;
+    content << fin.rdbuf();
+
+    if (fin.bad()) {
+        return {};
+    }
+
+    return std::make_shared<std::string const>(std::move(content).str());
+}
+
+/**
+ * @brief Returns the precompressed variant of the file, empty if there is no smaller one
+ */
+std::shared_ptr<std::string const> readVariant(fs::path path, char const* extension, std::size_t size) {
+    path += extension;
+
+    std::error_code ec;
+
+    if (!fs::is_regular_file(path, ec)) {
+        return {};
+    }
+
+    auto variant = readFile(path);
+
+    if (!variant || variant->size() >= size) {
+        return {};
+    }
+
+    return variant;
+}
+
+bool isCompressible(std::string_view content_type) {
+    return content_type.substr(0, 5) == "text/" || content_type == "application/javascript" ||
+           content_type == "application/json" || content_type == "application/xml" ||
+           content_type == "image/svg+xml";
+}
+
+bool endsWith(std::string_view value, std::string_view suffix) {
+    return value.size() >= suffix.size() && value.substr(value.size() - suffix.size()) == suffix;
+}
+
+std::size_t getSize(StaticFileCache::Asset const& asset) {
+    return asset.body->size() + (asset.gzip ? asset.gzip->size() : 0) + (asset.brotli ? asset.brotli->size() : 0);
+}
+
+}  // namespace
+
+StaticFileCache::StaticFileCache(net::io_context& ioc, fs::path docs, std::size_t max_file_size, std::size_t capacity)
+    : docs_{std::move(docs)},
+      max_file_size_{max_file_size},
+      capacity_{capacity},
+      enabled_{capacity != 0},
+      events_{ioc} {}
+
+StaticFileCache::~StaticFileCache() = default;
+
+void StaticFileCache::start() {
+    if (!enabled_) {
+        return;
+    }
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotify_fd_ < 0) {
+        // Without the notifications changed files would be served stale
+        std::cerr << "StaticFileCache::start: " << std::strerror(errno) << ", cache is disabled" << std::endl;
+        enabled_ = false;
+        return;
+    }
+
+    events_.assign(inotify_fd_);
+    watch(docs_);
+    doReadEvents();
+
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator{docs_, ec}; !ec && it != fs::recursive_directory_iterator{};
+         it.increment(ec)) {
+        auto const& path = it->path();
+
+        if (!it->is_regular_file(ec) || endsWith(path.native(), ".gz") || endsWith(path.native(), ".br")) {
+            continue;
+        }
+
+        if (it->file_size(ec) <= max_file_size_) {
+            load("/" + path.lexically_relative(docs_).generic_string());
+        }
+    }
+}
+
+std::shared_ptr<StaticFileCache::Asset const> StaticFileCache::find(std::string_view path) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return {};
+    }
+
+    {
+        std::shared_lock lock{mutex_};
+
+        if (auto const it = assets_.find(std::string{path}); it != assets_.end()) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return load(std::string{path});
+}
+
+StaticFileCache::Statistics StaticFileCache::getStatistics() const noexcept {
+    std::size_t entries;
+    {
+        std::shared_lock lock{mutex_};
+        entries = assets_.size();
+    }
+
+    return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed), entries,
+            size_.load(std::memory_order_relaxed), capacity_};
+}
+
+std::shared_ptr<StaticFileCache::Asset const> StaticFileCache::load(std::string const& path) {
+    std::uint64_t generation;
+    {
+        std::shared_lock lock{mutex_};
+        generation = generation_;
+    }
+
+    auto file_path = docs_;
+    file_path += path;
+
+    std::error_code ec;
+
+    if (!fs::is_regular_file(file_path, ec) || fs::file_size(file_path, ec) > max_file_size_ || ec) {
+        return {};
+    }
+
+    auto asset = std::make_shared<Asset>();
+    asset->body = readFile(file_path);
+
+    if (!asset->body) {
+        return {};
+    }
+
+    asset->content_type = utils::getMimeType(file_path.native());
+    asset->etag = (boost::format("\"%016x\"") % utils::hash64(*asset->body)).str();
+    asset->brotli = readVariant(file_path, ".br", asset->body->size());
+    asset->gzip = readVariant(file_path, ".gz", asset->body->size());
+
+    if (!asset->gzip && asset->body->size() >= MIN_COMPRESSED_SIZE && isCompressible(asset->content_type)) {
+        auto gzip = utils::gzip(*asset->body);
+
+        if (gzip.size() < asset->body->size()) {
+            asset->gzip = std::make_shared<std::string const>(std::move(gzip));
+        }
+    }
+
+    auto const size = getSize(*asset);
+
+    std::unique_lock lock{mutex_};
+
+    // File changed while it was loaded, next access loads it again
+    if (generation != generation_ || !enabled_.load(std::memory_order_relaxed)) {
+        return asset;
+    }
+
+    if (size_.load(std::memory_order_relaxed) + size > capacity_) {
+        return asset;
+    }
+
+    if (auto const [it, inserted] = assets_.emplace(path, asset); !inserted) {
+        return it->second;
+    }
+
+    size_.fetch_add(size, std::memory_order_relaxed);
+    return asset;
+}
+
+void StaticFileCache::watch(fs::path const& directory) {
+    auto const wd = inotify_add_watch(inotify_fd_, directory.c_str(), WATCH_MASK);
+
+    if (wd < 0) {
+        std::cerr << "StaticFileCache::watch: " << directory << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    directories_[wd] = directory;
+
+    std::error_code ec;
+    for (auto it = fs::directory_iterator{directory, ec}; !ec && it != fs::directory_iterator{}; it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            watch(it->path());
+        }
+    }
+}
+
+void StaticFileCache::doReadEvents() {
+    events_.async_read_some(net::buffer(events_buffer_), [this](boost::system::error_code ec, std::size_t size) {
+        onReadEvents(ec, size);
+    });
+}
+
+void StaticFileCache::onReadEvents(boost::system::error_code ec, std::size_t size) {
+    if (ec == net::error::operation_aborted) {
+        return;
+    }
+
+    if (ec) {
+        // Changes cannot be tracked anymore, cached files could become stale
+        std::cerr << "StaticFileCache::onReadEvents: " << ec.message() << ", cache is disabled" << std::endl;
+        enabled_ = false;
+        clear();
+        return;
+    }
+
+    for (std::size_t offset = 0; offset < size;) {
+        inotify_event event;
+        std::memcpy(&event, events_buffer_.data() + offset, sizeof(event));
+
+        std::string_view const name{events_buffer_.data() + offset + sizeof(event),
+                                    ::strnlen(events_buffer_.data() + offset + sizeof(event), event.len)};
+        offset += sizeof(event) + event.len;
+
+        // Some events were lost
+        if (event.mask & IN_Q_OVERFLOW) {
+            clear();
+            continue;
+        }
+
+        if (event.mask & IN_IGNORED) {
+            directories_.erase(event.wd);
+            continue;
+        }
+
+        auto const it = directories_.find(event.wd);
+
+        if (it == directories_.end()) {
+            continue;
+        }
+
+        // Directory changes move or remove many files at once
+        if (event.mask & (IN_ISDIR | IN_DELETE_SELF | IN_MOVE_SELF)) {
+            if ((event.mask & IN_ISDIR) && (event.mask & (IN_CREATE | IN_MOVED_TO))) {
+                watch(it->second / name);
+            }
+
+            clear();
+            continue;
+        }
+
+        invalidate("/" + (it->second / name).lexically_relative(docs_).generic_string());
+    }
+
+    doReadEvents();
+}
+
+void StaticFileCache::invalidate(std::string path) {
+    if (endsWith(path, ".gz") || endsWith(path, ".br")) {
+        path.resize(path.size() - 3);
+    }
+
+    std::unique_lock lock{mutex_};
+    ++generation_;
+
+    if (auto const it = assets_.find(path); it != assets_.end()) {
+        size_.fetch_sub(getSize(*it->second), std::memory_order_relaxed);
+        assets_.erase(it);
+    }
+}
+
+void StaticFileCache::clear() {
+    std::unique_lock lock{mutex_};
+    ++generation_;
+
+    assets_.clear();
+    size_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Net.hpp"
+
+/**
+ * @brief In-memory cache of the served documents.
+ *
+ * Small files are loaded at startup and on first access into immutable shared buffers, together with
+ * everything the response needs: content type, ETag and the compressed variants. Variants are taken from
+ * the precompressed ".br" and ".gz" files next to the file, gzip variant of a text file without one is
+ * compressed on load. Directory is watched with inotify and the changed files are dropped from the cache,
+ * they are loaded again on the next access.
+ */
+class StaticFileCache {
+public:
+    struct Asset {
+        std::shared_ptr<std::string const> body;
+        // Empty when there is no variant or it isn't smaller than the body
+        std::shared_ptr<std::string const> gzip;
+        std::shared_ptr<std::string const> brotli;
+        std::string content_type;
+        // Quoted, hash of the body
+        std::string etag;
+    };
+
+    struct Statistics {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::size_t entries;
+        std::size_t size;
+        std::size_t capacity;
+    };
+
+    /**
+     * @param ioc Io context on which the directory changes are handled
+     * @param docs Served documents directory
+     * @param max_file_size Maximum size of the cached file, larger files are not cached
+     * @param capacity Maximum size in bytes of all cached files with their variants, 0 disables the cache
+     */
+    StaticFileCache(net::io_context& ioc, std::filesystem::path docs, std::size_t max_file_size,
+                    std::size_t capacity);
+
+    ~StaticFileCache();
+
+    StaticFileCache(StaticFileCache const&) = delete;
+    StaticFileCache& operator=(StaticFileCache const&) = delete;
+
+    /**
+     * @brief Starts watching the documents directory and loads its small files
+     */
+    void start();
+
+    /**
+     * @brief Returns the asset of the request path ("/js/main.js"), file is loaded on the first access.
+     * Empty when the file is not a regular file, is too large or the cache is full.
+     */
+    std::shared_ptr<Asset const> find(std::string_view path);
+
+    Statistics getStatistics() const noexcept;
+
+private:
+    /**
+     * @brief Loads the file of the request path and inserts it into the cache
+     */
+    std::shared_ptr<Asset const> load(std::string const& path);
+
+    /**
+     * @brief Watches the directory and its subdirectories
+     */
+    void watch(std::filesystem::path const& directory);
+
+    void doReadEvents();
+
+    void onReadEvents(boost::system::error_code ec, std::size_t size);
+
+    /**
+     * @brief Drops the asset of the request path, variant file drops the asset of its file
+     */
+    void invalidate(std::string path);
+
+    /**
+     * @brief Drops all assets
+     */
+    void clear();
+
+    std::filesystem::path docs_;
+    std::size_t max_file_size_;
+    std::size_t capacity_;
+    // Cache is disabled when the directory changes cannot be watched
+    std::atomic<bool> enabled_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Asset const>> assets_;
+    // Raised on every invalidation, asset loaded before it is not inserted
+    std::uint64_t generation_{0};
+
+    int inotify_fd_{-1};
+    net::posix::stream_descriptor events_;
+    // Watched directories by their watch descriptors
+    std::unordered_map<int, std::filesystem::path> directories_;
+    alignas(8) std::array<char, 16 * 1024> events_buffer_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::size_t> size_{0};
+};
@@ -1,19 +1,63 @@
 #include "WebSocketSession.hpp"
 
+#include <algorithm>
 #include <boost/json.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <iostream>
 
+#include "CountBatchSession.hpp"
 #include "SharedState.hpp"
+#include "dto/CountMessageDto.hpp"
+#include "dto/JsonArena.hpp"
 
 namespace uuids = boost::uuids;
 namespace json = boost::json;
 
-WebSocketSession::WebSocketSession(tcp::socket&& socket, std::shared_ptr<SharedState> const& shared_state)
-    : id_{shared_state->createUuid()}, ws_{std::move(socket)}, shared_state_{shared_state} {}
+// Maximum size of the received message
+auto constexpr READ_MESSAGE_LIMIT{4 * 1024 * 1024U};
 
-WebSocketSession::~WebSocketSession() { shared_state_->leave(this); }
+// Count requests of a session which are counted plus the messages which are not written yet, next
+// messages are read after some of them are written
+auto constexpr MAX_PENDING{64U};
+
+// Characters which are counted when the request doesn't specify them
+auto constexpr DEFAULT_CHARACTERS{"I"};
+
+namespace {
+
+/**
+ * @brief Parsed count request which is shared with the counting
+ */
+struct SharedCountMessageDto {
+    SharedCountMessageDto(std::shared_ptr<dto::JsonArena> a, dto::CountMessageDto d)
+        : arena{std::move(a)}, dto{std::move(d)}, data{dto.getData()} {}
+
+    // Storage of the parsed message, destroyed last
+    std::shared_ptr<dto::JsonArena> arena;
+    dto::CountMessageDto dto;
+    std::string_view data;
+};
+
+}  // namespace
+
+WebSocketSession::WebSocketSession(net::io_context& ioc, tcp::socket&& socket,
+                                   std::shared_ptr<SharedState> const& shared_state)
+    : ioc_{ioc},
+      id_{shared_state->createUuid()},
+      ws_{std::move(socket)},
+      shared_state_{shared_state},
+      flush_window_{shared_state->getWebSocketFlushWindow()},
+      flush_timer_{ws_.get_executor()} {
+    ws_.read_message_max(READ_MESSAGE_LIMIT);
+}
+
+WebSocketSession::~WebSocketSession() {
+    shared_state_->leave(this);
+
+    // Messages which were not written leave the queue with the session
+    metrics::add(metrics::Gauge::ws_queued_messages, -static_cast<std::int64_t>(queue_.size()));
+}
 
 void WebSocketSession::fail(beast::error_code ec, char const* what) {
     if (ec == net::error::operation_aborted || ec == websocket::error::closed) {
@@ -35,6 +79,16 @@ void WebSocketSession::onAccept(beast::error_code ec) {
     json::value value{{"type", "id"}, {"data", uuids::to_string(id_)}};
     send(std::make_shared<std::string>(json::serialize(value)));
 
+    doRead();
+}
+
+void WebSocketSession::doRead() {
+    // Client which doesn't read the results is not able to queue unlimited work or results
+    if (in_flight_ + queue_.size() >= MAX_PENDING) {
+        read_paused_ = true;
+        return;
+    }
+
     ws_.async_read(buffer_, beast::bind_front_handler(&WebSocketSession::onRead, shared_from_this()));
 }
 
@@ -43,24 +97,165 @@ void WebSocketSession::onRead(beast::error_code ec, std::size_t) {
         return fail(ec, "WebSocketSession::onRead");
     }
 
+    if (ws_.got_text()) {
+        auto const data = buffer_.data();
+        handleMessage({static_cast<char const*>(data.data()), data.size()});
+    } else {
+        sendError("Binary messages are not supported");
+    }
+
     buffer_.consume(buffer_.size());
 
-    ws_.async_read(buffer_, beast::bind_front_handler(&WebSocketSession::onRead, shared_from_this()));
+    // Next request is read without waiting for the result of this one
+    doRead();
+}
+
+void WebSocketSession::handleMessage(std::string_view message) {
+    // Arena is reused only when no counting holds the data parsed into it, otherwise new one is created
+    if (arena_ && arena_.use_count() == 1) {
+        arena_->reset();
+    } else {
+        arena_ = std::make_shared<dto::JsonArena>();
+    }
+
+    std::shared_ptr<SharedCountMessageDto> request;
+
+    try {
+        auto const parse_start = metrics::Clock::now();
+        request =
+            std::make_shared<SharedCountMessageDto>(arena_, dto::CountMessageDto::parse(message, arena_->storage()));
+        metrics::observeSince(metrics::Histogram::dto_parse, parse_start);
+    } catch (std::runtime_error const& e) {
+        return sendError(e.what());
+    }
+
+    auto const characters = request->dto.getCharacters();
+
+    // Counting shares the parsed message, data is not copied
+    CountBatchSession::Document document{SharedData{request, &request->data}, {}};
+    for (auto const c : characters.empty() ? std::string_view{DEFAULT_CHARACTERS} : characters) {
+        document.characters.insert(c);
+    }
+
+    std::vector<CountBatchSession::Document> documents;
+    documents.push_back(std::move(document));
+
+    ++in_flight_;
+
+    std::make_shared<CountBatchSession>(ioc_, shared_state_, std::move(documents))
+        ->run([self = shared_from_this(), request_id = request->dto.getRequestId()](json::array results) {
+            net::post(self->ws_.get_executor(), [self, request_id, results = std::move(results)]() mutable {
+                self->onCounted(request_id, std::move(results));
+            });
+        });
+}
+
+void WebSocketSession::onCounted(uuids::uuid request_id, json::array results) {
+    --in_flight_;
+
+    auto& result = results[0].get_object();
+    auto const* error = result.if_contains("error");
+
+    // Counts of a single character are sent as the binary record, same as the other results
+    if (binary_ && error == nullptr && result.size() == 1) {
+        onSend(std::make_shared<std::string const>(
+                   encodeBinaryResult(request_id, result.begin()->value().to_number<std::uint64_t>())),
+               true);
+    } else {
+        json::object value;
+        value["type"] = "count_result";
+
+        auto& data = value["data"].emplace_object();
+        data["request_id"] = uuids::to_string(request_id);
+
+        if (error != nullptr) {
+            data["error"] = error->get_string();
+        } else {
+            data["counts"] = std::move(result);
+        }
+
+        onSend(std::make_shared<std::string const>(json::serialize(value)), false);
+    }
+}
+
+void WebSocketSession::sendError(std::string_view error) {
+    json::value value{{"type", "error"}, {"data", error}};
+    onSend(std::make_shared<std::string const>(json::serialize(value)), false);
+}
+
+void WebSocketSession::send(std::shared_ptr<std::string const> const& msg, bool binary) {
+    net::post(ws_.get_executor(),
+              beast::bind_front_handler(&WebSocketSession::onSend, shared_from_this(), msg, binary,
+                                        metrics::Clock::now()));
+}
+
+void WebSocketSession::onSend(std::shared_ptr<std::string const> const& msg, bool binary,
+                              metrics::Clock::time_point queued) {
+    queue_.push_back({msg, binary, queued});
+    metrics::add(metrics::Gauge::ws_queued_messages, 1);
+
+    if (writing_) {
+        return;
+    }
+
+    writing_ = true;
+
+    // First message waits for the others, so they are sent in the same frame
+    if (coalesce_ && flush_window_.count() > 0) {
+        flush_timer_.expires_after(flush_window_);
+        flush_timer_.async_wait(beast::bind_front_handler(&WebSocketSession::onFlush, shared_from_this()));
+        return;
+    }
+
+    doWrite();
 }
 
-void WebSocketSession::send(std::shared_ptr<std::string const> const& msg) {
-    net::post(ws_.get_executor(), beast::bind_front_handler(&WebSocketSession::onSend, shared_from_this(), msg));
+void WebSocketSession::onFlush(beast::error_code ec) {
+    if (ec) {
+        return fail(ec, "WebSocketSession::onFlush");
+    }
+
+    doWrite();
 }
 
-void WebSocketSession::onSend(std::shared_ptr<std::string const> const& msg) {
-    queue_.push_back(msg);
+void WebSocketSession::doWrite() {
+    auto const binary = queue_.front().binary;
+    ws_.binary(binary);
+
+    // Frame holds the messages of the same type from the front of the queue
+    written_count_ = 1;
+    if (coalesce_) {
+        while (written_count_ < queue_.size() && queue_[written_count_].binary == binary) {
+            ++written_count_;
+        }
+    }
 
-    if (queue_.size() > 1) {
+    if (written_count_ == 1) {
+        ws_.async_write(net::buffer(*queue_.front().data),
+                        beast::bind_front_handler(&WebSocketSession::onWrite, shared_from_this()));
         return;
     }
 
-    ws_.async_write(net::buffer(*queue_.front()),
-                    beast::bind_front_handler(&WebSocketSession::onWrite, shared_from_this()));
+    frame_.clear();
+
+    if (binary) {
+        // Binary records are self delimiting, so they are simply concatenated
+        for (std::size_t i = 0; i < written_count_; ++i) {
+            frame_ += *queue_[i].data;
+        }
+    } else {
+        // Messages are serialized JSON values, so the array is built without parsing them
+        frame_ += '[';
+
+        for (std::size_t i = 0; i < written_count_; ++i) {
+            frame_ += *queue_[i].data;
+            frame_ += ',';
+        }
+
+        frame_.back() = ']';
+    }
+
+    ws_.async_write(net::buffer(frame_), beast::bind_front_handler(&WebSocketSession::onWrite, shared_from_this()));
 }
 
 void WebSocketSession::onWrite(beast::error_code ec, std::size_t) {
@@ -68,12 +263,72 @@ void WebSocketSession::onWrite(beast::error_code ec, std::size_t) {
         return fail(ec, "WebSocketSession::onWrite");
     }
 
-    queue_.erase(queue_.begin());
+    auto const now = metrics::Clock::now();
+
+    for (std::size_t i = 0; i < written_count_; ++i) {
+        metrics::observe(metrics::Histogram::ws_delivery, now - queue_[i].queued);
+    }
 
+    metrics::increment(metrics::Counter::ws_messages_sent, written_count_);
+    metrics::add(metrics::Gauge::ws_queued_messages, -static_cast<std::int64_t>(written_count_));
+
+    queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(written_count_));
+
+    // Written results make room for the next requests
+    if (read_paused_) {
+        read_paused_ = false;
+        doRead();
+    }
+
+    // Messages queued during the write are written without waiting for the flush window
     if (!queue_.empty()) {
-        ws_.async_write(net::buffer(*queue_.front()),
-                        beast::bind_front_handler(&WebSocketSession::onWrite, shared_from_this()));
+        return doWrite();
     }
+
+    writing_ = false;
 }
 
 uuids::uuid WebSocketSession::getId() const noexcept { return id_; }
+
+std::string WebSocketSession::encodeBinaryResult(uuids::uuid request_id, std::uint64_t result) {
+    std::string record(request_id.begin(), request_id.end());
+
+    do {
+        auto byte = static_cast<unsigned char>(result & 0x7F);
+        result >>= 7;
+
+        if (result != 0) {
+            byte |= 0x80;
+        }
+
+        record.push_back(static_cast<char>(byte));
+    } while (result != 0);
+
+    return record;
+}
+
+bool WebSocketSession::isDeflateEnabled() const noexcept { return shared_state_->isWebSocketDeflateEnabled(); }
+
+bool WebSocketSession::offersBinary(beast::string_view protocols) noexcept {
+    // Subprotocols are separated by commas and optional whitespace
+    while (!protocols.empty()) {
+        auto const end = std::min(protocols.find(','), protocols.size());
+        auto protocol = protocols.substr(0, end);
+
+        while (!protocol.empty() && (protocol.front() == ' ' || protocol.front() == '\t')) {
+            protocol.remove_prefix(1);
+        }
+
+        while (!protocol.empty() && (protocol.back() == ' ' || protocol.back() == '\t')) {
+            protocol.remove_suffix(1);
+        }
+
+        if (protocol == BINARY_SUBPROTOCOL) {
+            return true;
+        }
+
+        protocols.remove_prefix(std::min(end + 1, protocols.size()));
+    }
+
+    return false;
+}
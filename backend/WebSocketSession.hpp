@@ -1,15 +1,29 @@
 #pragma once
 
+#include <boost/json/array.hpp>
 #include <boost/uuid/uuid.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
 
 #include "Beast.hpp"
+#include "Metrics.hpp"
 #include "Net.hpp"
+#include "utils/Url.hpp"
 
 class SharedState;
 
+namespace dto {
+class JsonArena;
+}
+
+// Subprotocol of the clients which receive the counting results in the binary format
+auto constexpr BINARY_SUBPROTOCOL{"chcount.binary"};
+
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
 public:
-    WebSocketSession(tcp::socket&& socket, std::shared_ptr<SharedState> const& state);
+    WebSocketSession(net::io_context& ioc, tcp::socket&& socket, std::shared_ptr<SharedState> const& state);
 
     ~WebSocketSession();
 
@@ -27,8 +41,14 @@ public:
      * @brief Send msg to the websocket client
      *
      * @param msg Message
+     * @param binary Message is sent in a binary frame, otherwise in a text frame
+     */
+    void send(std::shared_ptr<std::string const> const& msg, bool binary = false);
+
+    /**
+     * @brief Returns true if the client negotiated the binary results during the handshake
      */
-    void send(std::shared_ptr<std::string const> const& msg);
+    bool isBinary() const noexcept { return binary_; }
 
     /**
      * @brief Get the websocket id
@@ -37,6 +57,12 @@ public:
      */
     boost::uuids::uuid getId() const noexcept;
 
+    /**
+     * @brief Returns the binary record of the result, 16 bytes of the request id followed by the
+     * count as unsigned LEB128 varint
+     */
+    static std::string encodeBinaryResult(boost::uuids::uuid request_id, std::uint64_t result);
+
 private:
     /**
      * @brief Called when the error occured during the session lifetime
@@ -46,6 +72,11 @@ private:
      */
     void fail(beast::error_code ec, char const* what);
 
+    /**
+     * @brief Returns true if the server offers permessage-deflate
+     */
+    bool isDeflateEnabled() const noexcept;
+
     /**
      * @brief Handles accept of the websocket connection
      * and sends the connection id to the client
@@ -55,12 +86,37 @@ private:
     void onAccept(beast::error_code ec);
 
     /**
-     * @brief Empyt buffer and initiate new async read from websocket
+     * @brief Initiates async read of the next message, unless the session has too many pending messages
+     */
+    void doRead();
+
+    /**
+     * @brief Handles the received message and initiates the next read
      *
      * @param ec Error code
      */
     void onRead(beast::error_code ec, std::size_t);
 
+    /**
+     * @brief Starts counting of the count request message, result is sent when it is counted
+     *
+     * @param message Received message
+     */
+    void handleMessage(std::string_view message);
+
+    /**
+     * @brief Sends the result of the count request, called on the session executor
+     *
+     * @param request_id Request id chosen by the client
+     * @param results Results of the request, single object which maps characters to the counts or {"error": "..."}
+     */
+    void onCounted(boost::uuids::uuid request_id, boost::json::array results);
+
+    /**
+     * @brief Sends the error of the message which cannot be handled
+     */
+    void sendError(std::string_view error);
+
     /**
      * @brief Erase first element from message queue and if queue is not empty
      * initiate another async write with next message from queue
@@ -74,26 +130,87 @@ private:
      * initiate async write if no other writes are currently in progress
      *
      * @param msg Message to send
+     * @param binary Message is sent in a binary frame
+     * @param queued Time when the message was sent, for the delivery latency
+     */
+    void onSend(std::shared_ptr<std::string const> const& msg, bool binary,
+                metrics::Clock::time_point queued = metrics::Clock::now());
+
+    /**
+     * @brief Writes the queued messages. In coalescing mode queued messages of the same frame type are
+     * written in a single frame, text messages as a JSON array and binary records one after another.
+     */
+    void doWrite();
+
+    /**
+     * @brief Handler called after the flush window expires
+     *
+     * @param ec Error code
      */
-    void onSend(std::shared_ptr<std::string const> const& msg);
+    void onFlush(beast::error_code ec);
 
+    net::io_context& ioc_;
     boost::uuids::uuid id_;
     beast::flat_buffer buffer_;
     websocket::stream<beast::tcp_stream> ws_;
     std::shared_ptr<SharedState> shared_state_;
-    std::vector<std::shared_ptr<std::string const>> queue_;
+    struct Message {
+        std::shared_ptr<std::string const> data;
+        bool binary;
+        metrics::Clock::time_point queued;
+    };
+
+    /**
+     * @brief Returns true if the list of the handshake subprotocols contains the binary subprotocol
+     */
+    static bool offersBinary(beast::string_view protocols) noexcept;
+
+    std::deque<Message> queue_;
+    // Client receives the counting results in the binary format
+    bool binary_{false};
+    // Client asked for the queued messages to be merged into a single frame
+    bool coalesce_{false};
+    // Time for which the first queued message waits for the others in coalescing mode
+    std::chrono::microseconds flush_window_;
+    net::steady_timer flush_timer_;
+    // Write or flush window is in progress
+    bool writing_{false};
+    // Number of queued messages in the current write
+    std::size_t written_count_{0};
+    // Frame of the coalesced messages, kept to reuse its storage
+    std::string frame_;
+    // Count requests which are being counted
+    std::size_t in_flight_{0};
+    // Read is paused until some of the pending results are written
+    bool read_paused_{false};
+    // Storage of the parsed count requests, reused once nothing references it
+    std::shared_ptr<dto::JsonArena> arena_;
 };
 
 // DEFINITIONS
 
 template <class Body, class Allocator>
 inline void WebSocketSession::run(http::request<Body, http::basic_fields<Allocator>> req) {
+    coalesce_ = utils::getQueryParameter(req.target(), "coalesce") == "1";
+    binary_ = offersBinary(req[http::field::sec_websocket_protocol]);
+
     // Set suggested timeout settings for the websocket
     ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
 
+    // Compression is negotiated during the handshake, only with the clients which offer it
+    if (isDeflateEnabled()) {
+        websocket::permessage_deflate deflate;
+        deflate.server_enable = true;
+        ws_.set_option(deflate);
+    }
+
     // Set a decorator to change the Server of the handshake
-    ws_.set_option(websocket::stream_base::decorator([](websocket::response_type& res) {
+    ws_.set_option(websocket::stream_base::decorator([binary = binary_](websocket::response_type& res) {
         res.set(http::field::server, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-chcount-server");
+
+        if (binary) {
+            res.set(http::field::sec_websocket_protocol, BINARY_SUBPROTOCOL);
+        }
     }));
 
     // Accept the websocket handshake
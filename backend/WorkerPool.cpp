@@ -0,0 +1,261 @@
+#include "WorkerPool.hpp"
+
+#include <iostream>
+
+namespace bp = boost::process;
+namespace fs = std::filesystem;
+
+// Interval between the pings of idle workers
+auto constexpr HEALTH_CHECK_INTERVAL{std::chrono::seconds(10)};
+// Time in which the worker must answer the ping
+auto constexpr PING_TIMEOUT{std::chrono::seconds(5)};
+// Time in which the worker must count the job
+auto constexpr JOB_TIMEOUT{std::chrono::seconds(60)};
+// Worker which exits sooner than this after its start is started again only after this delay
+auto constexpr RESTART_DELAY{std::chrono::seconds(1)};
+
+WorkerPool::Worker::Worker(net::io_context& ioc, std::size_t index)
+    : index{index}, in{ioc}, out{ioc}, deadline{ioc} {}
+
+WorkerPool::WorkerPool(net::io_context& ioc, fs::path executable, unsigned workers_count, std::size_t queue_size)
+    : ioc_{ioc},
+      strand_{net::make_strand(ioc)},
+      executable_{std::move(executable)},
+      queue_size_{queue_size},
+      workers_(workers_count),
+      health_check_timer_{ioc} {}
+
+void WorkerPool::start() {
+    net::post(strand_, [self = shared_from_this()] {
+        for (std::size_t i = 0; i < self->workers_.size(); ++i) {
+            self->spawn(i);
+        }
+
+        self->onHealthCheck({});
+    });
+}
+
+bool WorkerPool::isSaturated() const noexcept { return jobs_.load() >= workers_.size() + queue_size_; }
+
+bool WorkerPool::submit(counter::CharacterSet characters, CountPayload payload, Handler handler) {
+    // Reserve the place for the job, so the limit holds for the concurrent submits too
+    auto jobs = jobs_.load();
+    do {
+        if (jobs >= workers_.size() + queue_size_) {
+            return false;
+        }
+    } while (!jobs_.compare_exchange_weak(jobs, jobs + 1));
+
+    auto const type = std::holds_alternative<fs::path>(payload) ? worker::RequestType::file
+                                                                : worker::RequestType::data;
+
+    net::post(strand_, [self = shared_from_this(),
+                        job = Job{type, std::move(characters), std::move(payload), std::move(handler)}]() mutable {
+        self->queue_.push_back(std::move(job));
+        self->dispatch();
+    });
+
+    return true;
+}
+
+void WorkerPool::spawn(std::size_t index) {
+    auto worker = std::make_shared<Worker>(ioc_, index);
+    workers_[index] = worker;
+
+    try {
+        worker->child = bp::child(executable_.string(), "--worker", bp::std_in < worker->in, bp::std_out > worker->out);
+    } catch (bp::process_error const& e) {
+        std::cerr << "WorkerPool::spawn: " << e.what() << std::endl;
+
+        worker->deadline.expires_after(RESTART_DELAY);
+        worker->deadline.async_wait(net::bind_executor(strand_, [self = shared_from_this(), index](auto ec) {
+            if (!ec) {
+                self->spawn(index);
+            }
+        }));
+        return;
+    }
+
+    worker->started = std::chrono::steady_clock::now();
+    worker->running = true;
+
+    dispatch();
+}
+
+void WorkerPool::restart(std::shared_ptr<Worker> const& worker, std::string const& why) {
+    if (!worker->running) {
+        return;
+    }
+
+    std::cerr << "WorkerPool: Restarting worker " << worker->index << ": " << why << std::endl;
+
+    worker->running = false;
+
+    boost::system::error_code ec;
+    worker->deadline.cancel();
+    worker->in.close(ec);
+    worker->out.close(ec);
+
+    std::error_code child_ec;
+    worker->child.terminate(child_ec);
+
+    if (worker->job) {
+        auto job = std::move(*worker->job);
+        worker->job.reset();
+        complete(std::move(job), {worker::Status::error, {}, why});
+    }
+
+    auto const index = worker->index;
+
+    // Worker which fails right after the start would be restarted in a tight loop
+    if (std::chrono::steady_clock::now() - worker->started < RESTART_DELAY) {
+        worker->deadline.expires_after(RESTART_DELAY);
+        worker->deadline.async_wait(net::bind_executor(strand_, [self = shared_from_this(), index](auto ec) {
+            if (!ec) {
+                self->spawn(index);
+            }
+        }));
+    } else {
+        spawn(index);
+    }
+}
+
+void WorkerPool::dispatch() {
+    for (auto const& worker : workers_) {
+        if (queue_.empty()) {
+            return;
+        }
+
+        if (worker && worker->running && !worker->job) {
+            auto job = std::move(queue_.front());
+            queue_.pop_front();
+            send(worker, std::move(job));
+        }
+    }
+}
+
+void WorkerPool::send(std::shared_ptr<Worker> const& worker, Job job) {
+    std::string_view payload;
+
+    if (auto const* file_path = std::get_if<fs::path>(&job.payload)) {
+        worker->request_path = fs::absolute(*file_path).string();
+        payload = worker->request_path;
+    } else if (auto const& data = std::get<SharedData>(job.payload)) {
+        payload = *data;
+    }
+
+    try {
+        worker->request_header = worker::encodeRequestHeader(job.type, job.characters, payload.size());
+    } catch (std::runtime_error const& e) {
+        return complete(std::move(job), {worker::Status::error, {}, e.what()});
+    }
+
+    auto const timeout = job.type == worker::RequestType::ping ? PING_TIMEOUT : JOB_TIMEOUT;
+
+    // Job keeps the payload alive until the response is read
+    worker->job = std::move(job);
+
+    std::array<net::const_buffer, 2> const buffers{net::buffer(worker->request_header), net::buffer(payload)};
+
+    net::async_write(worker->in, buffers,
+                     net::bind_executor(strand_, [self = shared_from_this(), worker](auto ec, std::size_t size) {
+                         self->onWrite(worker, ec, size);
+                     }));
+
+    net::async_read(worker->out, net::buffer(worker->response_prefix),
+                    net::bind_executor(strand_, [self = shared_from_this(), worker](auto ec, std::size_t size) {
+                        self->onReadPrefix(worker, ec, size);
+                    }));
+
+    worker->deadline.expires_after(timeout);
+    worker->deadline.async_wait(
+        net::bind_executor(strand_, [self = shared_from_this(), worker](auto ec) { self->onDeadline(worker, ec); }));
+}
+
+void WorkerPool::onWrite(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t) {
+    if (ec && worker->running) {
+        restart(worker, "Request write failed: " + ec.message());
+    }
+}
+
+void WorkerPool::onReadPrefix(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t) {
+    if (!worker->running) {
+        return;
+    }
+
+    if (ec) {
+        return restart(worker, "Response read failed: " + ec.message());
+    }
+
+    auto const size = worker::decodeFrameSize(worker->response_prefix.data());
+
+    if (size > worker::MAX_FRAME_SIZE) {
+        return restart(worker, "Response frame is too large");
+    }
+
+    worker->response_body.resize(size);
+
+    net::async_read(worker->out, net::buffer(worker->response_body),
+                    net::bind_executor(strand_, [self = shared_from_this(), worker](auto ec, std::size_t size) {
+                        self->onReadBody(worker, ec, size);
+                    }));
+}
+
+void WorkerPool::onReadBody(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t) {
+    if (!worker->running) {
+        return;
+    }
+
+    if (ec) {
+        return restart(worker, "Response read failed: " + ec.message());
+    }
+
+    worker::Response response;
+    try {
+        response = worker::decodeResponse(worker->response_body);
+    } catch (std::runtime_error const& e) {
+        return restart(worker, e.what());
+    }
+
+    worker->deadline.cancel();
+
+    auto job = std::move(*worker->job);
+    worker->job.reset();
+    complete(std::move(job), std::move(response));
+
+    dispatch();
+}
+
+void WorkerPool::onDeadline(std::shared_ptr<Worker> const& worker, boost::system::error_code ec) {
+    // Timer is cancelled when the response arrives
+    if (ec == net::error::operation_aborted || !worker->running || !worker->job) {
+        return;
+    }
+
+    restart(worker, "Worker didn't respond in time");
+}
+
+void WorkerPool::onHealthCheck(boost::system::error_code ec) {
+    if (ec == net::error::operation_aborted) {
+        return;
+    }
+
+    for (auto const& worker : workers_) {
+        if (worker && worker->running && !worker->job) {
+            send(worker, Job{worker::RequestType::ping, {}, SharedData{}, {}});
+        }
+    }
+
+    health_check_timer_.expires_after(HEALTH_CHECK_INTERVAL);
+    health_check_timer_.async_wait(
+        net::bind_executor(strand_, [self = shared_from_this()](auto ec) { self->onHealthCheck(ec); }));
+}
+
+void WorkerPool::complete(Job job, worker::Response response) {
+    if (job.type == worker::RequestType::ping) {
+        return;
+    }
+
+    --jobs_;
+    job.handler(std::move(response));
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/process.hpp>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CountPayload.hpp"
+#include "Counter.hpp"
+#include "Net.hpp"
+#include "WorkerProtocol.hpp"
+
+/**
+ * @brief Pool of long-lived `chcount --worker` processes.
+ *
+ * Workers are started once and every counting job is sent to an idle worker as
+ * a request frame over its standard input, response frame is read from its
+ * standard output. Idle workers are pinged periodically. Worker which exits,
+ * breaks the protocol, or doesn't answer in time is killed and started again,
+ * its job fails. Number of jobs which are queued or running is limited.
+ *
+ * All the pool state is accessed only on the pool strand.
+ */
+class WorkerPool : public std::enable_shared_from_this<WorkerPool> {
+public:
+    /**
+     * @brief Called with the worker response, or with Status::error when the job failed
+     */
+    using Handler = std::function<void(worker::Response)>;
+
+    /**
+     * @param ioc IO context on which the pipes are served
+     * @param executable Path to the chcount executable
+     * @param workers_count Number of worker processes
+     * @param queue_size Maximum number of jobs waiting for an idle worker
+     */
+    WorkerPool(net::io_context& ioc, std::filesystem::path executable, unsigned workers_count,
+               std::size_t queue_size);
+
+    /**
+     * @brief Starts the workers and the health checks
+     */
+    void start();
+
+    /**
+     * @brief Returns true when new jobs would be rejected
+     */
+    bool isSaturated() const noexcept;
+
+    /**
+     * @brief Queues the counting job
+     *
+     * @param characters Characters which are counted
+     * @param payload Counted data or file
+     * @param handler Called on the pool strand when the job is done
+     * @return False if the job is rejected because the pool is saturated
+     */
+    bool submit(counter::CharacterSet characters, CountPayload payload, Handler handler);
+
+private:
+    struct Job {
+        worker::RequestType type;
+        counter::CharacterSet characters;
+        CountPayload payload;
+        // Empty for health checks
+        Handler handler;
+    };
+
+    struct Worker {
+        Worker(net::io_context& ioc, std::size_t index);
+
+        std::size_t index;
+        boost::process::async_pipe in;
+        boost::process::async_pipe out;
+        boost::process::child child;
+        net::steady_timer deadline;
+        std::chrono::steady_clock::time_point started;
+        // False when the process is not started or is stopped, handlers of the stopped worker are ignored
+        bool running{false};
+
+        // Job in progress, empty when the worker is idle
+        std::optional<Job> job;
+        worker::RequestHeader request_header;
+        std::string request_path;
+        std::array<char, worker::FRAME_PREFIX_SIZE> response_prefix;
+        std::string response_body;
+    };
+
+    /**
+     * @brief Starts the worker process in the slot, retries later if the process cannot be started
+     */
+    void spawn(std::size_t index);
+
+    /**
+     * @brief Kills the worker, fails its job and starts the new worker in its place
+     *
+     * @param worker Worker
+     * @param why Reason which is logged and sent to the job handler
+     */
+    void restart(std::shared_ptr<Worker> const& worker, std::string const& why);
+
+    /**
+     * @brief Sends queued jobs to the idle workers
+     */
+    void dispatch();
+
+    /**
+     * @brief Writes the job request to the worker and waits for the response
+     */
+    void send(std::shared_ptr<Worker> const& worker, Job job);
+
+    void onWrite(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t);
+    void onReadPrefix(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t);
+    void onReadBody(std::shared_ptr<Worker> const& worker, boost::system::error_code ec, std::size_t);
+    void onDeadline(std::shared_ptr<Worker> const& worker, boost::system::error_code ec);
+
+    /**
+     * @brief Pings all idle workers and schedules the next health check
+     */
+    void onHealthCheck(boost::system::error_code ec);
+
+    /**
+     * @brief Completes the job of the worker
+     */
+    void complete(Job job, worker::Response response);
+
+    net::io_context& ioc_;
+    net::strand<net::io_context::executor_type> strand_;
+    std::filesystem::path executable_;
+    std::size_t queue_size_;
+
+    std::vector<std::shared_ptr<Worker>> workers_;
+    std::deque<Job> queue_;
+    net::steady_timer health_check_timer_;
+
+    // Counting jobs which are queued or running, updated outside of the strand on submit
+    std::atomic<std::size_t> jobs_{0};
+};
@@ -0,0 +1,117 @@
+#include "CountBatchDto.hpp"
+
+#include <boost/json/array.hpp>
+#include <boost/json/object.hpp>
+#include <boost/json/stream_parser.hpp>
+#include <boost/json/string.hpp>
+#include <boost/uuid/string_generator.hpp>
+#include <stdexcept>
+
+namespace json = boost::json;
+namespace uuids = boost::uuids;
+
+namespace dto {
+
+// Parser temporary stack, allocated on the stack so that parsing allocates only in the storage
+auto constexpr PARSER_BUFFER_SIZE{1024U};
+
+// Maximum number of documents in a single batch
+auto constexpr MAX_DOCUMENTS{10000U};
+
+namespace {
+
+json::array const& getDocuments(json::value const& body) noexcept {
+    return body.get_object().find("documents")->value().get_array();
+}
+
+std::string_view getString(json::object const& document, std::string_view key) noexcept {
+    auto const it = document.find(key);
+
+    if (it == document.end()) {
+        return {};
+    }
+
+    auto const& value = it->value().get_string();
+    return {value.data(), value.size()};
+}
+
+}  // namespace
+
+CountBatchDto CountBatchDto::parse(std::string_view body, json::storage_ptr storage) {
+    unsigned char parser_buffer[PARSER_BUFFER_SIZE];
+    json::stream_parser parser{{}, {}, parser_buffer};
+    parser.reset(std::move(storage));
+
+    boost::system::error_code ec;
+    parser.write(body.data(), body.size(), ec);
+
+    if (!ec) {
+        parser.finish(ec);
+    }
+
+    if (ec) {
+        throw std::runtime_error("Request body is not in valid json format");
+    }
+
+    CountBatchDto result;
+    result.body_ = parser.release();
+
+    auto const* obj_body = result.body_.if_object();
+
+    if (obj_body == nullptr) {
+        throw std::runtime_error("Request body is not in valid json format");
+    }
+
+    auto const* id_value = obj_body->if_contains("id");
+    auto const* documents_value = obj_body->if_contains("documents");
+
+    if (documents_value == nullptr || !documents_value->is_array() || (id_value != nullptr && !id_value->is_string())) {
+        throw std::runtime_error("Request body is not valid json object");
+    }
+
+    if (documents_value->get_array().size() > MAX_DOCUMENTS) {
+        throw std::runtime_error("Request has too many documents");
+    }
+
+    for (auto const& document : documents_value->get_array()) {
+        auto const* obj_document = document.if_object();
+
+        if (obj_document == nullptr) {
+            throw std::runtime_error("Request document is not valid json object");
+        }
+
+        auto const* data_value = obj_document->if_contains("data");
+        auto const* characters_value = obj_document->if_contains("characters");
+
+        auto const valid_characters = characters_value == nullptr ||
+                                      (characters_value->is_string() && !characters_value->get_string().empty());
+
+        if (data_value == nullptr || !data_value->is_string() || !valid_characters) {
+            throw std::runtime_error("Request document is not valid json object");
+        }
+    }
+
+    if (id_value != nullptr) {
+        auto const& id = id_value->get_string();
+
+        try {
+            result.id_ = uuids::string_generator{}(id.data(), id.data() + id.size());
+        } catch (std::runtime_error const&) {
+            throw std::runtime_error("Request \"id\" is not in valid format");
+        }
+    }
+
+    return result;
+}
+
+std::size_t CountBatchDto::size() const noexcept { return getDocuments(body_).size(); }
+
+std::string_view CountBatchDto::getData(std::size_t index) const noexcept {
+    return getString(getDocuments(body_)[index].get_object(), "data");
+}
+
+std::string_view CountBatchDto::getCharacters(std::size_t index) const noexcept {
+    return getString(getDocuments(body_)[index].get_object(), "characters");
+}
+
+}  // namespace dto
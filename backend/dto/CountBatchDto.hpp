@@ -0,0 +1,52 @@
+#pragma once
+
+#include <boost/json/storage_ptr.hpp>
+#include <boost/json/value.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace dto {
+
+/**
+ * @brief Batch count request, many documents with their own characters. As in CountDto the
+ * parsed body is kept in the DTO, so data and characters are views into it.
+ */
+class CountBatchDto {
+public:
+    /**
+     * @brief Parses the request body, throws std::runtime_error if the body is not valid
+     *
+     * @param body Request body
+     * @param storage Storage of the parsed values, must outlive the DTO
+     */
+    static CountBatchDto parse(std::string_view body, boost::json::storage_ptr storage = {});
+
+    /**
+     * @brief Returns the session id, empty when the results are returned in the response
+     */
+    std::optional<boost::uuids::uuid> getId() const noexcept { return id_; }
+
+    /**
+     * @brief Returns number of documents
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * @brief Returns view of the document data, valid while the DTO lives
+     */
+    std::string_view getData(std::size_t index) const noexcept;
+
+    /**
+     * @brief Returns view of the document characters, empty when the document doesn't specify them
+     */
+    std::string_view getCharacters(std::size_t index) const noexcept;
+
+private:
+    std::optional<boost::uuids::uuid> id_;
+    // Parsed body, documents are objects in its "documents" array
+    boost::json::value body_;
+};
+
+}  // namespace dto
@@ -0,0 +1,233 @@
+#include "CountDto.hpp"
+
+#include <boost/json/basic_parser_impl.hpp>
+#include <boost/uuid/string_generator.hpp>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace json = boost::json;
+namespace uuids = boost::uuids;
+
+namespace dto {
+
+/**
+ * @brief Handler of the SAX parser which keeps only "id" and "data" of the top level object.
+ * String without escapes is passed by the parser as a view into the input, which is
+ * used as the data without a copy.
+ */
+class CountDtoHandler {
+public:
+    static constexpr std::size_t max_object_size = std::size_t(-1);
+    static constexpr std::size_t max_array_size = std::size_t(-1);
+    static constexpr std::size_t max_key_size = std::size_t(-1);
+    static constexpr std::size_t max_string_size = std::size_t(-1);
+
+    CountDtoHandler(std::string_view body, json::storage_ptr storage)
+        : body_{body}, id_text_{storage}, result_{std::move(storage)} {}
+
+    bool on_document_begin(boost::system::error_code&) { return true; }
+    bool on_document_end(boost::system::error_code&) { return true; }
+
+    bool on_object_begin(boost::system::error_code&) {
+        onValue(true);
+        ++depth_;
+        return true;
+    }
+
+    bool on_object_end(std::size_t, boost::system::error_code&) {
+        --depth_;
+        return true;
+    }
+
+    bool on_array_begin(boost::system::error_code&) {
+        onValue();
+        ++depth_;
+        return true;
+    }
+
+    bool on_array_end(std::size_t, boost::system::error_code&) {
+        --depth_;
+        return true;
+    }
+
+    bool on_key_part(json::string_view s, std::size_t, boost::system::error_code&) {
+        if (depth_ == 1) {
+            key_.append(s.data(), s.size());
+        }
+
+        return true;
+    }
+
+    bool on_key(json::string_view s, std::size_t, boost::system::error_code&) {
+        if (depth_ == 1) {
+            // Key is copied only when it's split into parts
+            std::string_view key{s.data(), s.size()};
+
+            if (!key_.empty()) {
+                key_.append(key);
+                key = key_;
+            }
+
+            field_ = key == "id" ? Field::id : key == "data" ? Field::data : Field::other;
+            key_.clear();
+        }
+
+        return true;
+    }
+
+    bool on_string_part(json::string_view s, std::size_t n, boost::system::error_code&) {
+        if (depth_ != 1) {
+            return onValue();
+        }
+
+        // First part of the string, previous value of a duplicate key is replaced
+        auto const first = n == s.size();
+
+        if (field_ == Field::data) {
+            if (first) {
+                result_.unescaped_.clear();
+            }
+
+            result_.escaped_ = true;
+            result_.unescaped_.append(s);
+        } else if (field_ == Field::id) {
+            if (first) {
+                id_text_.clear();
+            }
+
+            id_text_.append(s);
+        }
+
+        return true;
+    }
+
+    bool on_string(json::string_view s, std::size_t n, boost::system::error_code&) {
+        if (depth_ != 1) {
+            return onValue();
+        }
+
+        auto const whole = n == s.size();
+
+        if (field_ == Field::data) {
+            has_data_ = true;
+
+            if (whole && isInBody(s)) {
+                result_.escaped_ = false;
+                result_.data_ = {s.data(), s.size()};
+            } else {
+                // Parser unescaped the string into its own buffer
+                if (whole) {
+                    result_.unescaped_.clear();
+                }
+
+                result_.escaped_ = true;
+                result_.unescaped_.append(s);
+            }
+        } else if (field_ == Field::id) {
+            if (whole) {
+                id_text_.clear();
+            }
+
+            id_text_.append(s);
+            has_id_ = true;
+        }
+
+        field_ = Field::other;
+        return true;
+    }
+
+    bool on_number_part(json::string_view, boost::system::error_code&) { return true; }
+    bool on_int64(std::int64_t, json::string_view, boost::system::error_code&) { return onValue(); }
+    bool on_uint64(std::uint64_t, json::string_view, boost::system::error_code&) { return onValue(); }
+    bool on_double(double, json::string_view, boost::system::error_code&) { return onValue(); }
+    bool on_bool(bool, boost::system::error_code&) { return onValue(); }
+    bool on_null(boost::system::error_code&) { return onValue(); }
+    bool on_comment_part(json::string_view, boost::system::error_code&) { return true; }
+    bool on_comment(json::string_view, boost::system::error_code&) { return true; }
+
+    /**
+     * @brief Returns the DTO after the whole body is parsed, throws if it's not a valid count request
+     */
+    CountDto release() {
+        if (!is_object_) {
+            throw std::runtime_error("Request body is not in valid json format");
+        }
+
+        if (!has_data_ || !types_valid_) {
+            throw std::runtime_error("Request body is not valid json object");
+        }
+
+        if (has_id_) {
+            try {
+                result_.id_ = uuids::string_generator{}(id_text_.data(), id_text_.data() + id_text_.size());
+            } catch (std::runtime_error const&) {
+                throw std::runtime_error("Request \"id\" is not in valid format");
+            }
+        }
+
+        return std::move(result_);
+    }
+
+private:
+    enum class Field { other, id, data };
+
+    /**
+     * @brief Checks the value which is not a string of the top level object, or the top level value itself
+     *
+     * @param object Value is an object
+     */
+    bool onValue(bool object = false) noexcept {
+        if (depth_ == 0) {
+            is_object_ = object;
+        } else if (depth_ == 1 && field_ != Field::other) {
+            // "id" and "data" must be strings
+            types_valid_ = false;
+            field_ = Field::other;
+        }
+
+        return true;
+    }
+
+    bool isInBody(json::string_view s) const noexcept {
+        std::less<char const*> const less;
+        return !less(s.data(), body_.data()) && !less(body_.data() + body_.size(), s.data() + s.size());
+    }
+
+    std::string_view body_;
+    std::size_t depth_{0};
+    bool is_object_{false};
+    bool has_id_{false};
+    bool has_data_{false};
+    bool types_valid_{true};
+    Field field_{Field::other};
+    // Key split into parts by escapes
+    std::string key_;
+    json::string id_text_;
+    CountDto result_;
+};
+
+CountDto CountDto::parse(std::string_view body, json::storage_ptr storage) {
+    json::basic_parser<CountDtoHandler> parser{json::parse_options{}, body, std::move(storage)};
+
+    boost::system::error_code ec;
+    auto const consumed = parser.write_some(false, body.data(), body.size(), ec);
+
+    if (ec || consumed < body.size()) {
+        throw std::runtime_error("Request body is not in valid json format");
+    }
+
+    return parser.handler().release();
+}
+
+std::string_view CountDto::getData() const noexcept {
+    // Short unescaped strings are stored inline, so the view is taken from the current location of the string
+    if (escaped_) {
+        return {unescaped_.data(), unescaped_.size()};
+    }
+
+    return data_;
+}
+
+}  // namespace dto
@@ -1,63 +1,53 @@
 #pragma once
 
-#include <boost/json.hpp>
+#include <boost/json/storage_ptr.hpp>
+#include <boost/json/string.hpp>
 #include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_io.hpp>
-#include <string>
+#include <optional>
+#include <string_view>
 
 namespace dto {
 
+/**
+ * @brief Count request. Body is parsed without building the JSON document, data without escapes
+ * is a view into the request body, so it's not copied at all.
+ */
 class CountDto {
 public:
-    template <class RequestBody>
-    static CountDto parse(RequestBody const& body);
-
-    boost::uuids::uuid getId() const noexcept { return id_; }
-    void setId(boost::uuids::uuid id) { id_ = std::move(id); }
-
-    std::string getData() const noexcept { return data_; }
-    void getData(std::string_view data) { data_ = data; }
+    /**
+     * @brief Parses the request body, throws std::runtime_error if the body is not valid
+     *
+     * @param body Request body, must outlive the DTO
+     * @param storage Storage of the unescaped data, must outlive the DTO
+     */
+    static CountDto parse(std::string_view body, boost::json::storage_ptr storage = {});
+
+    /**
+     * @brief Returns the session id, empty when the request doesn't have it (synchronous counting)
+     */
+    std::optional<boost::uuids::uuid> getId() const noexcept { return id_; }
+
+    /**
+     * @brief Returns view of the data, valid while the body and the DTO live
+     */
+    std::string_view getData() const noexcept;
+
+    /**
+     * @brief Returns true if the data is a view into the request body, false if it had to be unescaped
+     */
+    bool isDataInBody() const noexcept { return !escaped_; }
 
 private:
-    boost::uuids::uuid id_;
-    std::string data_;
-};
-
-// DEFINITIONS
-
-template <class RequestBody>
-CountDto CountDto::parse(RequestBody const& body) {
-    namespace json = boost::json;
-    namespace uuids = boost::uuids;
-
-    CountDto result;
-
-    boost::system::error_code ec;
-    json::value json_body = json::parse(body, ec);
+    explicit CountDto(boost::json::storage_ptr storage) : unescaped_{std::move(storage)} {}
 
-    if (ec || !json_body.is_object()) {
-        throw std::runtime_error("Request body is not in valid json format");
-    }
+    std::optional<boost::uuids::uuid> id_;
+    // Data in the request body, used when it doesn't contain escapes
+    std::string_view data_;
+    // Data contains escapes and it's unescaped into the storage
+    bool escaped_{false};
+    boost::json::string unescaped_;
 
-    auto obj_body = json_body.as_object();
-
-    if (!obj_body.contains("id") || !obj_body.contains("data") || !obj_body.at("id").is_string() ||
-        !obj_body.at("data").is_string()) {
-        throw std::runtime_error("Request body is not valid json object");
-    }
-
-    auto id_value = obj_body.at("id");
-    auto data_value = obj_body.at("data");
-
-    try {
-        result.id_ = boost::lexical_cast<uuids::uuid>(id_value.as_string().c_str());
-    } catch (boost::bad_lexical_cast const&) {
-        throw std::runtime_error("Request \"id\" is not in valid format");
-    }
-
-    result.data_ = data_value.as_string().c_str();
-
-    return result;
-}
+    friend class CountDtoHandler;
+};
 
 }  // namespace dto
@@ -0,0 +1,98 @@
+#include "CountMessageDto.hpp"
+
+#include <boost/json/object.hpp>
+#include <boost/json/stream_parser.hpp>
+#include <boost/json/string.hpp>
+#include <boost/uuid/string_generator.hpp>
+#include <stdexcept>
+
+namespace json = boost::json;
+namespace uuids = boost::uuids;
+
+namespace dto {
+
+// Parser temporary stack, allocated on the stack so that parsing allocates only in the storage
+auto constexpr PARSER_BUFFER_SIZE{1024U};
+
+namespace {
+
+std::string_view getString(json::value const& message, std::string_view key) noexcept {
+    auto const& request = message.get_object().find("data")->value().get_object();
+    auto const it = request.find(key);
+
+    if (it == request.end()) {
+        return {};
+    }
+
+    auto const& value = it->value().get_string();
+    return {value.data(), value.size()};
+}
+
+}  // namespace
+
+CountMessageDto CountMessageDto::parse(std::string_view message, json::storage_ptr storage) {
+    unsigned char parser_buffer[PARSER_BUFFER_SIZE];
+    json::stream_parser parser{{}, {}, parser_buffer};
+    parser.reset(std::move(storage));
+
+    boost::system::error_code ec;
+    parser.write(message.data(), message.size(), ec);
+
+    if (!ec) {
+        parser.finish(ec);
+    }
+
+    if (ec) {
+        throw std::runtime_error("Message is not in valid json format");
+    }
+
+    CountMessageDto result;
+    result.message_ = parser.release();
+
+    auto const* obj_message = result.message_.if_object();
+
+    if (obj_message == nullptr) {
+        throw std::runtime_error("Message is not in valid json format");
+    }
+
+    auto const* type_value = obj_message->if_contains("type");
+    auto const* data_value = obj_message->if_contains("data");
+
+    if (type_value == nullptr || !type_value->is_string() || type_value->get_string() != "count") {
+        throw std::runtime_error("Unsupported message type");
+    }
+
+    if (data_value == nullptr || !data_value->is_object()) {
+        throw std::runtime_error("Message is not valid json object");
+    }
+
+    auto const& request = data_value->get_object();
+
+    auto const* request_id_value = request.if_contains("request_id");
+    auto const* request_data_value = request.if_contains("data");
+    auto const* characters_value = request.if_contains("characters");
+
+    auto const valid_characters =
+        characters_value == nullptr || (characters_value->is_string() && !characters_value->get_string().empty());
+
+    if (request_id_value == nullptr || !request_id_value->is_string() || request_data_value == nullptr ||
+        !request_data_value->is_string() || !valid_characters) {
+        throw std::runtime_error("Message is not valid json object");
+    }
+
+    auto const& request_id = request_id_value->get_string();
+
+    try {
+        result.request_id_ = uuids::string_generator{}(request_id.data(), request_id.data() + request_id.size());
+    } catch (std::runtime_error const&) {
+        throw std::runtime_error("Message \"request_id\" is not in valid format");
+    }
+
+    return result;
+}
+
+std::string_view CountMessageDto::getData() const noexcept { return getString(message_, "data"); }
+
+std::string_view CountMessageDto::getCharacters() const noexcept { return getString(message_, "characters"); }
+
+}  // namespace dto
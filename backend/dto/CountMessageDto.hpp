@@ -0,0 +1,45 @@
+#pragma once
+
+#include <boost/json/storage_ptr.hpp>
+#include <boost/json/value.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <string_view>
+
+namespace dto {
+
+/**
+ * @brief Count request received over the WebSocket, {"type": "count", "data": {...}}. As in
+ * CountDto the parsed message is kept in the DTO, so data and characters are views into it.
+ */
+class CountMessageDto {
+public:
+    /**
+     * @brief Parses the message, throws std::runtime_error if the message is not valid
+     *
+     * @param message WebSocket message
+     * @param storage Storage of the parsed values, must outlive the DTO
+     */
+    static CountMessageDto parse(std::string_view message, boost::json::storage_ptr storage = {});
+
+    /**
+     * @brief Returns the request id chosen by the client, result is sent with it
+     */
+    boost::uuids::uuid getRequestId() const noexcept { return request_id_; }
+
+    /**
+     * @brief Returns view of the data, valid while the DTO lives
+     */
+    std::string_view getData() const noexcept;
+
+    /**
+     * @brief Returns view of the characters, empty when the request doesn't specify them
+     */
+    std::string_view getCharacters() const noexcept;
+
+private:
+    boost::uuids::uuid request_id_;
+    // Parsed message, request is the object in its "data"
+    boost::json::value message_;
+};
+
+}  // namespace dto
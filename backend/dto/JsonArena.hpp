@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <boost/json/monotonic_resource.hpp>
+#include <boost/json/storage_ptr.hpp>
+
+namespace dto {
+
+/**
+ * @brief Monotonic storage for parsed JSON with an inline initial buffer.
+ * Parsing a typical request doesn't allocate at all. The session reuses the arena
+ * for the next request once nothing references the data parsed into it.
+ */
+class JsonArena {
+public:
+    JsonArena() : resource_{buffer_.data(), buffer_.size()} {}
+
+    JsonArena(JsonArena const&) = delete;
+    JsonArena& operator=(JsonArena const&) = delete;
+
+    /**
+     * @brief Returns non owning storage pointer, arena must outlive the values allocated with it
+     */
+    boost::json::storage_ptr storage() noexcept { return &resource_; }
+
+    /**
+     * @brief Releases all the parsed values, inline buffer is used again
+     */
+    void reset() noexcept { resource_.release(); }
+
+private:
+    std::array<unsigned char, 16 * 1024> buffer_;
+    boost::json::monotonic_resource resource_;
+};
+
+}  // namespace dto
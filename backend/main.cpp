@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <boost/program_options.hpp>
+#include <csignal>
 #include <filesystem>
 #include <iostream>
 
+#include "IoContextPool.hpp"
 #include "Listener.hpp"
 #include "SharedState.hpp"
 
@@ -12,10 +15,12 @@ using tcp = boost::asio::ip::tcp;
 
 struct Options {
     std::string host;
-    fs::path docs;
-    fs::path tmp_storage;
-    fs::path chcount_executable;
     net::ip::port_type port;
+    unsigned io_threads_count;
+    bool io_context_per_core;
+    unsigned acceptors_count;
+    Listener::Options listener_options;
+    SharedState::Options state_options;
 };
 
 /**
@@ -31,6 +36,9 @@ Options parseArgumentOptions(int argc, char** argv);
 int main(int argc, char** argv) {
     auto const options = parseArgumentOptions(argc, argv);
 
+    // Write to the pipe of an exited chcount process must fail with EPIPE instead of killing the server
+    std::signal(SIGPIPE, SIG_IGN);
+
     auto const& port = options.port;
 
     boost::system::error_code ec;
@@ -41,31 +49,35 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    auto const threads_count = std::thread::hardware_concurrency() - 1;
-
-    net::io_context ioc{static_cast<int>(threads_count)};
-
-    std::make_shared<Listener>(
-        ioc, tcp::endpoint{host, port},
-        std::make_shared<SharedState>(options.docs, options.tmp_storage, options.chcount_executable))
-        ->run();
+    // Per core mode runs a pinned io context on every thread, otherwise all threads run the same context
+    IoContextPool io_contexts{options.io_context_per_core ? options.io_threads_count : 1U,
+                              options.io_context_per_core ? 1U : options.io_threads_count,
+                              options.io_context_per_core};
+
+    auto& ioc = io_contexts.getIoContext(0);
+
+    auto const shared_state = std::make_shared<SharedState>(ioc, options.state_options);
+
+    if (options.acceptors_count == 0) {
+        // Single acceptor spreads the connections over the io contexts
+        std::make_shared<Listener>(io_contexts, std::nullopt, tcp::endpoint{host, port}, options.listener_options,
+                                   shared_state)
+            ->run();
+    } else {
+        // Kernel spreads the connections over the SO_REUSEPORT acceptors, every acceptor keeps its
+        // connections on its own io context
+        for (unsigned i = 0; i < options.acceptors_count; ++i) {
+            std::make_shared<Listener>(io_contexts, i % io_contexts.size(), tcp::endpoint{host, port},
+                                       options.listener_options, shared_state)
+                ->run();
+        }
+    }
 
     net::signal_set signals(ioc, SIGINT, SIGTERM);
-    signals.async_wait([&ioc](boost::system::error_code const&, int) { ioc.stop(); });
-
-    std::vector<std::thread> threads;
-    threads.reserve(threads_count);
-
-    for (auto i = threads_count; i > 0; --i) {
-        threads.emplace_back([&ioc] { ioc.run(); });
-    }
+    signals.async_wait([&io_contexts](boost::system::error_code const&, int) { io_contexts.stop(); });
 
     std::cout << "Server listening on: " << host.to_string() << ":" << port << std::endl;
-    ioc.run();
-
-    for (auto& t : threads) {
-        t.join();
-    }
+    io_contexts.run();
 
     return EXIT_SUCCESS;
 }
@@ -91,6 +103,11 @@ Options parseArgumentOptions(int argc, char** argv) {
     std::string docs;
     std::string tmp_storage;
     std::string chcount_executable;
+    std::string count_mode;
+    unsigned job_queue_timeout;
+    unsigned job_timeout;
+    unsigned ws_flush_window;
+    auto const default_threads_count = std::max(std::thread::hardware_concurrency(), 1U);
 
     po::options_description desc("Options");
 
@@ -101,7 +118,59 @@ Options parseArgumentOptions(int argc, char** argv) {
         ("port,P", po::value<std::int32_t>(&port)->default_value(3000), "Port on which server listens")
         ("docs,D", po::value<std::string>(&docs), "Served documents location directory")
         ("tmp-storage,T", po::value<std::string>(&tmp_storage)->default_value("."), "Temporary storage directory")
-        ("chcount-executable", po::value<std::string>(&chcount_executable), "Chcount executable path");
+        ("chcount-executable", po::value<std::string>(&chcount_executable), "Chcount executable path")
+        ("count-mode", po::value<std::string>(&count_mode)->default_value("process"),
+            "Counting mode: process (chcount child process per request), in-process or worker (pool of persistent "
+            "chcount workers)")
+        ("io-threads", po::value<unsigned>(&result.io_threads_count)->default_value(default_threads_count),
+            "Number of threads which run the network io")
+        ("io-context-per-core", po::bool_switch(&result.io_context_per_core),
+            "Run a separate io context on every io thread, pinned to its own CPU. Connections are spread over the "
+            "contexts round robin and stay on one of them")
+        ("acceptors", po::value<unsigned>(&result.acceptors_count)->default_value(0),
+            "Number of SO_REUSEPORT acceptors, 0 is a single acceptor which spreads connections round robin. "
+            "With --io-context-per-core acceptor is on every io context, so use the number of io threads")
+        ("listen-backlog",
+            po::value<int>(&result.listener_options.backlog)->default_value(net::socket_base::max_listen_connections),
+            "Maximum length of the queue of pending connections of every acceptor")
+        ("tcp-defer-accept", po::value<int>(&result.listener_options.defer_accept)->default_value(0),
+            "Seconds for which the connection is not accepted until the client sends data, 0 disables it")
+        ("tcp-nodelay", po::value<bool>(&result.listener_options.no_delay)->default_value(true),
+            "Disable Nagle's algorithm on the accepted connections")
+        ("compute-threads",
+            po::value<unsigned>(&result.state_options.compute_threads_count)->default_value(default_threads_count),
+            "Number of in-process counting threads")
+        ("tmp-file-threshold",
+            po::value<std::size_t>(&result.state_options.tmp_file_threshold)->default_value(1024 * 1024),
+            "Request data size in bytes above which data is passed to the counter through a temporary file")
+        ("workers", po::value<unsigned>(&result.state_options.workers_count)->default_value(default_threads_count),
+            "Number of chcount worker processes")
+        ("worker-queue-size", po::value<std::size_t>(&result.state_options.worker_queue_size)->default_value(1024),
+            "Number of requests which wait for a free worker, requests over the limit are rejected")
+        ("max-jobs",
+            po::value<std::size_t>(&result.state_options.job_options.concurrency)->default_value(default_threads_count),
+            "Maximum number of counting requests which run at the same time in process and in-process mode")
+        ("job-queue-size", po::value<std::size_t>(&result.state_options.job_options.queue_size)->default_value(1024),
+            "Number of counting requests which wait for a free slot, requests over the limit are rejected")
+        ("job-queue-timeout", po::value<unsigned>(&job_queue_timeout)->default_value(5000),
+            "Milliseconds after which the waiting counting request is dropped, 0 disables the timeout")
+        ("job-timeout", po::value<unsigned>(&job_timeout)->default_value(30000),
+            "Milliseconds after which the chcount child process is killed, 0 disables the timeout")
+        ("sync-threshold", po::value<std::size_t>(&result.state_options.sync_threshold)->default_value(64 * 1024),
+            "Maximum request data size in bytes which is counted inline when the request asks for sync=1")
+        ("result-cache-size", po::value<std::size_t>(&result.state_options.result_cache_size)->default_value(65536),
+            "Maximum number of cached counting results, 0 disables the cache")
+        ("ws-flush-window", po::value<unsigned>(&ws_flush_window)->default_value(0),
+            "Microseconds for which the WebSocket message waits for the others, so they are sent in a single "
+            "frame. Applies to the connections opened with coalesce=1")
+        ("ws-deflate", po::bool_switch(&result.state_options.ws_deflate),
+            "Offer permessage-deflate compression to the WebSocket clients")
+        ("static-cache-size",
+            po::value<std::size_t>(&result.state_options.static_cache_size)->default_value(64 * 1024 * 1024),
+            "Maximum size in bytes of the served documents cached in the memory, 0 disables the cache")
+        ("static-cache-file-limit",
+            po::value<std::size_t>(&result.state_options.static_cache_file_limit)->default_value(1024 * 1024),
+            "Maximum size in bytes of the cached document, larger documents are sent with sendfile");
     // clang-format on
 
     try {
@@ -130,44 +199,87 @@ Options parseArgumentOptions(int argc, char** argv) {
             exitWithErrorMessage("Docs location path must be provided", desc);
         }
 
-        result.docs = fs::absolute(docs);
+        result.state_options.docs = fs::absolute(docs);
 
-        if (!fs::exists(result.docs)) {
+        if (!fs::exists(result.state_options.docs)) {
             exitWithErrorMessage("Docs location path doesn't exists", desc);
         }
 
-        if (!fs::is_directory(result.docs)) {
+        if (!fs::is_directory(result.state_options.docs)) {
             exitWithErrorMessage("Docs location path must be a directory", desc);
         }
 
         // tmp-storage checks
-        result.tmp_storage = fs::absolute(tmp_storage);
+        result.state_options.tmp_storage = fs::absolute(tmp_storage);
 
-        if (!fs::exists(result.tmp_storage)) {
+        if (!fs::exists(result.state_options.tmp_storage)) {
             exitWithErrorMessage("Temporary storage path doesn't exists", desc);
         }
 
-        if (!fs::is_directory(result.tmp_storage)) {
+        if (!fs::is_directory(result.state_options.tmp_storage)) {
             exitWithErrorMessage("Temporary storage path must be a direstory", desc);
         }
 
-        // chcount-executable checks
-        if (!vm.count("chcount-executable")) {
-            exitWithErrorMessage("Chcount path must be provided", desc);
+        // count-mode checks
+        if (count_mode == "process") {
+            result.state_options.count_mode = CountMode::process;
+        } else if (count_mode == "in-process") {
+            result.state_options.count_mode = CountMode::in_process;
+        } else if (count_mode == "worker") {
+            result.state_options.count_mode = CountMode::worker_pool;
+        } else {
+            exitWithErrorMessage("Count mode must be process, in-process or worker", desc);
         }
 
-        if (chcount_executable.empty()) {
-            exitWithErrorMessage("Chcount path cannot be empty", desc);
+        if (result.io_threads_count == 0) {
+            exitWithErrorMessage("Number of io threads must be positive", desc);
         }
 
-        result.chcount_executable = fs::absolute(chcount_executable);
+        if (result.listener_options.backlog <= 0) {
+            exitWithErrorMessage("Listen backlog must be positive", desc);
+        }
 
-        if (!fs::exists(result.chcount_executable)) {
-            exitWithErrorMessage("Chcount executable doesn't exists", desc);
+        if (result.listener_options.defer_accept < 0) {
+            exitWithErrorMessage("TCP defer accept must not be negative", desc);
         }
 
-        if (!fs::is_regular_file(result.chcount_executable)) {
-            exitWithErrorMessage("Chcount executable must be a regular file", desc);
+        result.listener_options.reuse_port = result.acceptors_count != 0;
+
+        if (result.state_options.compute_threads_count == 0) {
+            exitWithErrorMessage("Number of compute threads must be positive", desc);
+        }
+
+        if (result.state_options.workers_count == 0) {
+            exitWithErrorMessage("Number of workers must be positive", desc);
+        }
+
+        if (result.state_options.job_options.concurrency == 0) {
+            exitWithErrorMessage("Maximum number of jobs must be positive", desc);
+        }
+
+        result.state_options.job_options.queue_timeout = std::chrono::milliseconds{job_queue_timeout};
+        result.state_options.job_options.job_timeout = std::chrono::milliseconds{job_timeout};
+        result.state_options.ws_flush_window = std::chrono::microseconds{ws_flush_window};
+
+        // chcount-executable checks, executable is needed only for counting in child processes
+        if (result.state_options.count_mode != CountMode::in_process) {
+            if (!vm.count("chcount-executable")) {
+                exitWithErrorMessage("Chcount path must be provided", desc);
+            }
+
+            if (chcount_executable.empty()) {
+                exitWithErrorMessage("Chcount path cannot be empty", desc);
+            }
+
+            result.state_options.chcount_executable = fs::absolute(chcount_executable);
+
+            if (!fs::exists(result.state_options.chcount_executable)) {
+                exitWithErrorMessage("Chcount executable doesn't exists", desc);
+            }
+
+            if (!fs::is_regular_file(result.state_options.chcount_executable)) {
+                exitWithErrorMessage("Chcount executable must be a regular file", desc);
+            }
         }
 
         return result;
@@ -0,0 +1,12 @@
+#include "CharacterKey.hpp"
+
+std::string utils::getCharacterKey(char c) {
+    auto const byte = static_cast<unsigned char>(c);
+
+    if (byte < 0x80) {
+        return std::string(1, c);
+    }
+
+    // Two byte UTF-8 sequence of the code point
+    return {static_cast<char>(0xC0 | (byte >> 6)), static_cast<char>(0x80 | (byte & 0x3F))};
+}
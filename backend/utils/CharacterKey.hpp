@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace utils {
+
+/**
+ * @brief Returns the key of the counted byte in the JSON results. ASCII byte is the key itself, byte
+ * 0x80-0xFF is the character with the same code point (U+0080-U+00FF), so the key is valid UTF-8.
+ */
+std::string getCharacterKey(char c);
+
+}  // namespace utils
@@ -5,7 +5,10 @@ namespace content_type {
 
 auto constexpr text_plain{"text/plain"};
 auto constexpr text_html{"text/html"};
+// Prometheus text exposition format
+auto constexpr text_prometheus{"text/plain; version=0.0.4"};
 auto constexpr application_json{"application/json"};
+auto constexpr application_octet_stream{"application/octet-stream"};
 
 }  // namespace content_type
 }  // namespace utils
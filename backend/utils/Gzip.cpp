@@ -0,0 +1,55 @@
+#include "Gzip.hpp"
+
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/crc.hpp>
+#include <cstdint>
+#include <stdexcept>
+
+namespace zlib = boost::beast::zlib;
+
+namespace {
+
+// Magic, deflate method, no flags, no modification time, no extra flags, Unix
+unsigned char constexpr GZIP_HEADER[]{0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+
+void appendLittleEndian(std::string& out, std::uint32_t value) {
+    for (auto i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+}  // namespace
+
+std::string utils::gzip(std::string_view data, int level) {
+    zlib::deflate_stream stream;
+    // Raw deflate, the gzip header and trailer are written here
+    stream.reset(level, 15, 8, zlib::Strategy::normal);
+
+    std::string result(reinterpret_cast<char const*>(GZIP_HEADER), sizeof(GZIP_HEADER));
+    auto const header_size = result.size();
+    result.resize(header_size + stream.upper_bound(data.size()));
+
+    zlib::z_params params;
+    params.next_in = data.data();
+    params.avail_in = data.size();
+    params.next_out = result.data() + header_size;
+    params.avail_out = result.size() - header_size;
+
+    // Output buffer is large enough for the whole stream, so a single write finishes it
+    boost::system::error_code ec;
+    stream.write(params, zlib::Flush::finish, ec);
+
+    if (ec != zlib::error::end_of_stream) {
+        throw std::runtime_error("Cannot compress data: " + ec.message());
+    }
+
+    result.resize(header_size + params.total_out);
+
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+
+    appendLittleEndian(result, crc.checksum());
+    appendLittleEndian(result, static_cast<std::uint32_t>(data.size()));
+
+    return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/**
+ * @brief Compresses the data into the gzip format (RFC 1952) with the deflate of Boost.Beast,
+ * so no zlib dependency is needed
+ *
+ * @param data Data
+ * @param level Compression level, 0 to 9
+ * @return Compressed data
+ */
+std::string gzip(std::string_view data, int level = 9);
+
+}  // namespace utils
@@ -0,0 +1,173 @@
+#include "Hash.hpp"
+
+#include <cstring>
+#include <random>
+
+namespace {
+
+std::uint64_t constexpr PRIME_1{0x9E3779B185EBCA87ULL};
+std::uint64_t constexpr PRIME_2{0xC2B2AE3D27D4EB4FULL};
+std::uint64_t constexpr PRIME_3{0x165667B19E3779F9ULL};
+std::uint64_t constexpr PRIME_4{0x85EBCA77C2B2AE63ULL};
+std::uint64_t constexpr PRIME_5{0x27D4EB2F165667C5ULL};
+
+std::uint64_t rotl(std::uint64_t x, int r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+std::uint64_t read64(char const* p) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t read32(char const* p) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint64_t round(std::uint64_t acc, std::uint64_t input) noexcept {
+    acc += input * PRIME_2;
+    acc = rotl(acc, 31);
+    return acc * PRIME_1;
+}
+
+std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value) noexcept {
+    acc ^= round(0, value);
+    return acc * PRIME_1 + PRIME_4;
+}
+
+// SipHash initialization constants ("somepseudorandomlygeneratedbytes")
+std::uint64_t constexpr SIP_INIT_0{0x736F6D6570736575ULL};
+std::uint64_t constexpr SIP_INIT_1{0x646F72616E646F6DULL};
+std::uint64_t constexpr SIP_INIT_2{0x6C7967656E657261ULL};
+std::uint64_t constexpr SIP_INIT_3{0x7465646279746573ULL};
+
+struct SipState {
+    std::uint64_t v0;
+    std::uint64_t v1;
+    std::uint64_t v2;
+    std::uint64_t v3;
+
+    void rounds(int count) noexcept {
+        for (int i = 0; i < count; ++i) {
+            v0 += v1;
+            v1 = rotl(v1, 13);
+            v1 ^= v0;
+            v0 = rotl(v0, 32);
+            v2 += v3;
+            v3 = rotl(v3, 16);
+            v3 ^= v2;
+            v0 += v3;
+            v3 = rotl(v3, 21);
+            v3 ^= v0;
+            v2 += v1;
+            v1 = rotl(v1, 17);
+            v1 ^= v2;
+            v2 = rotl(v2, 32);
+        }
+    }
+
+    void compress(std::uint64_t m) noexcept {
+        v3 ^= m;
+        rounds(2);
+        v0 ^= m;
+    }
+
+    std::uint64_t finalize() noexcept {
+        rounds(4);
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+};
+
+}  // namespace
+
+std::uint64_t utils::hash64(std::string_view data, std::uint64_t seed) noexcept {
+    auto const* p = data.data();
+    auto const* const end = p + data.size();
+
+    std::uint64_t hash;
+
+    if (data.size() >= 32) {
+        // Four independent lanes over 32 byte stripes
+        auto v1 = seed + PRIME_1 + PRIME_2;
+        auto v2 = seed + PRIME_2;
+        auto v3 = seed;
+        auto v4 = seed - PRIME_1;
+
+        for (auto const* const limit = end - 32; p <= limit; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME_5;
+    }
+
+    hash += static_cast<std::uint64_t>(data.size());
+
+    for (; p + 8 <= end; p += 8) {
+        hash ^= round(0, read64(p));
+        hash = rotl(hash, 27) * PRIME_1 + PRIME_4;
+    }
+
+    if (p + 4 <= end) {
+        hash ^= static_cast<std::uint64_t>(read32(p)) * PRIME_1;
+        hash = rotl(hash, 23) * PRIME_2 + PRIME_3;
+        p += 4;
+    }
+
+    for (; p < end; ++p) {
+        hash ^= static_cast<std::uint64_t>(static_cast<unsigned char>(*p)) * PRIME_5;
+        hash = rotl(hash, 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+utils::Digest128 utils::keyedHash128(std::string_view data, HashKey const& key) noexcept {
+    auto const* p = data.data();
+    auto const* const end = p + data.size();
+
+    SipState state{key[0] ^ SIP_INIT_0, key[1] ^ SIP_INIT_1 ^ 0xEE, key[0] ^ SIP_INIT_2, key[1] ^ SIP_INIT_3};
+
+    for (; p + 8 <= end; p += 8) {
+        state.compress(read64(p));
+    }
+
+    // Last block holds the remaining bytes and the low byte of the size
+    auto last = static_cast<std::uint64_t>(data.size()) << 56;
+
+    for (int shift = 0; p < end; ++p, shift += 8) {
+        last |= static_cast<std::uint64_t>(static_cast<unsigned char>(*p)) << shift;
+    }
+
+    state.compress(last);
+
+    state.v2 ^= 0xEE;
+    auto const low = state.finalize();
+
+    state.v1 ^= 0xDD;
+    auto const high = state.finalize();
+
+    return {low, high};
+}
+
+utils::HashKey utils::createHashKey() {
+    std::random_device random_device;
+    std::uniform_int_distribution<std::uint64_t> distribution;
+
+    return {distribution(random_device), distribution(random_device)};
+}
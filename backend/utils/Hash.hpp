@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace utils {
+
+/**
+ * @brief Returns 64-bit hash of the data (XXH64), fast enough to key the data by its content
+ *
+ * @param data Data
+ * @param seed Seed
+ */
+std::uint64_t hash64(std::string_view data, std::uint64_t seed = 0) noexcept;
+
+// 128-bit secret key of the keyed hash
+using HashKey = std::array<std::uint64_t, 2>;
+
+// 128-bit digest, first element is the low half
+using Digest128 = std::array<std::uint64_t, 2>;
+
+/**
+ * @brief Returns 128-bit keyed hash of the data (SipHash-2-4-128). Unlike hash64 it's a pseudorandom
+ * function, so collisions cannot be crafted without the key.
+ *
+ * @param data Data
+ * @param key Secret key
+ */
+Digest128 keyedHash128(std::string_view data, HashKey const& key) noexcept;
+
+/**
+ * @brief Returns a random key, for the keyed hash of a single process
+ */
+HashKey createHashKey();
+
+}  // namespace utils
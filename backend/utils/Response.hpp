@@ -1,6 +1,8 @@
 #pragma once
 
 #include <boost/beast.hpp>
+#include <chrono>
+#include <string>
 
 #include "ContentType.hpp"
 
@@ -45,5 +47,19 @@ http::response<http::string_body> createServerError(http::request<Body, http::ba
     return res;
 }
 
+template <class Body, class Allocator>
+http::response<http::string_body> createServiceUnavailable(
+    http::request<Body, http::basic_fields<Allocator>> const& req, std::string_view why,
+    std::chrono::seconds retry_after) {
+    http::response<http::string_body> res{http::status::service_unavailable, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, content_type::text_plain);
+    res.set(http::field::retry_after, std::to_string(retry_after.count()));
+    res.keep_alive(req.keep_alive());
+    res.body() = std::string(why);
+    res.prepare_payload();
+    return res;
+}
+
 }  // namespace response
 }  // namespace utils
@@ -0,0 +1,57 @@
+#include "Url.hpp"
+
+#include <algorithm>
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percentDecode(std::string_view s) {
+    std::string result;
+    result.reserve(s.size());
+
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            result += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+            result += static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+            i += 2;
+        } else {
+            result += s[i];
+        }
+    }
+
+    return result;
+}
+
+}  // namespace
+
+std::string_view utils::getTargetPath(std::string_view target) { return target.substr(0, target.find('?')); }
+
+std::optional<std::string> utils::getQueryParameter(std::string_view target, std::string_view name) {
+    auto const query_begin = target.find('?');
+
+    if (query_begin == std::string_view::npos) {
+        return {};
+    }
+
+    auto query = target.substr(query_begin + 1);
+
+    while (!query.empty()) {
+        auto const parameter = query.substr(0, query.find('&'));
+        query.remove_prefix(std::min(parameter.size() + 1, query.size()));
+
+        auto const separator = parameter.find('=');
+
+        if (parameter.substr(0, separator) == name) {
+            return separator == std::string_view::npos ? std::string{} : percentDecode(parameter.substr(separator + 1));
+        }
+    }
+
+    return {};
+}
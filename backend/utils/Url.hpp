@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/**
+ * @brief Returns the path of the request target, without the query
+ */
+std::string_view getTargetPath(std::string_view target);
+
+/**
+ * @brief Returns the percent decoded value of the query parameter of the request target
+ *
+ * @param target Request target
+ * @param name Parameter name
+ * @return Value of the first parameter with the name, empty if there is no such parameter
+ */
+std::optional<std::string> getQueryParameter(std::string_view target, std::string_view name);
+
+}  // namespace utils
@@ -0,0 +1,137 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CountKernel.hpp"
+#include "Counter.hpp"
+#include "SyntheticData.hpp"
+
+using namespace bench;
+
+// Alignment of the counted data, larger than any kernel step
+auto constexpr DATA_ALIGNMENT{64U};
+
+// Data counted by the threads of the thread scaling benchmark, larger than the caches
+auto constexpr THREAD_DATA_SIZE{64 * 1024 * 1024U};
+
+namespace {
+
+std::vector<long> const ISAS{static_cast<long>(kernel::Isa::scalar), static_cast<long>(kernel::Isa::sse2),
+                             static_cast<long>(kernel::Isa::avx2), static_cast<long>(kernel::Isa::avx512)};
+
+/**
+ * @brief Selects the kernel of the benchmark, skips the benchmark if the CPU doesn't support it
+ *
+ * @return Kernel or nullptr if the benchmark is skipped
+ */
+kernel::CountFunction getKernel(benchmark::State& state, long isa_arg) {
+    auto const isa = static_cast<kernel::Isa>(isa_arg);
+    state.SetLabel(std::string{kernel::toString(isa)});
+
+    if (!kernel::isSupported(isa)) {
+        state.SkipWithError("Instruction set is not supported by the CPU");
+        return nullptr;
+    }
+
+    return kernel::getCountFunction(isa);
+}
+
+/**
+ * @brief Counts size bytes which start offset bytes after the aligned address
+ */
+void runKernel(benchmark::State& state, long isa_arg, std::size_t size, std::size_t offset, unsigned density) {
+    auto const count = getKernel(state, isa_arg);
+
+    if (count == nullptr) {
+        return;
+    }
+
+    auto const& data = getSyntheticData(size + DATA_ALIGNMENT + offset, density);
+    auto const misalignment = reinterpret_cast<std::uintptr_t>(data.data()) % DATA_ALIGNMENT;
+    auto const* begin = data.data() + (DATA_ALIGNMENT - misalignment) + offset;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(count(begin, size, MATCH_CHARACTER));
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+}
+
+/**
+ * @brief Throughput by kernel and buffer size
+ */
+void BM_CountKernel(benchmark::State& state) {
+    runKernel(state, state.range(0), static_cast<std::size_t>(state.range(1)), 0, 1);
+}
+
+/**
+ * @brief Throughput by kernel and offset of the data from the 64 byte alignment
+ */
+void BM_CountAlignment(benchmark::State& state) {
+    runKernel(state, state.range(0), 64 * 1024, static_cast<std::size_t>(state.range(1)), 1);
+}
+
+/**
+ * @brief Throughput by kernel and percent of the matching bytes
+ */
+void BM_CountDensity(benchmark::State& state) {
+    runKernel(state, state.range(0), 64 * 1024, 0, static_cast<unsigned>(state.range(1)));
+}
+
+/**
+ * @brief Throughput of the best kernel when all threads count data larger than the caches, shows the memory
+ * bandwidth limit
+ */
+void BM_CountThreads(benchmark::State& state) {
+    auto const& data = getSyntheticData(THREAD_DATA_SIZE, 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernel::count(data, MATCH_CHARACTER));
+    }
+
+    state.SetLabel(std::string{kernel::toString(kernel::detectIsa())});
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+}
+
+/**
+ * @brief Throughput of the character set counting by number of the counted characters and block size
+ */
+void BM_CountBlock(benchmark::State& state) {
+    auto const characters_count = static_cast<int>(state.range(0));
+    auto const size = static_cast<std::size_t>(state.range(1));
+
+    counter::CharacterSet characters;
+    for (auto i = 0; i < characters_count; ++i) {
+        characters.insert(static_cast<char>(MATCH_CHARACTER + i));
+    }
+
+    auto const& data = getSyntheticData(size, 1);
+
+    for (auto _ : state) {
+        counter::Histogram counts{};
+        counter::countBlock(data, characters, counts);
+        benchmark::DoNotOptimize(counts);
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+}
+
+}  // namespace
+
+BENCHMARK(BM_CountKernel)
+    ->ArgNames({"isa", "size"})
+    ->ArgsProduct({ISAS, {64, 4 * 1024, 64 * 1024, 1024 * 1024, 64 * 1024 * 1024}});
+
+BENCHMARK(BM_CountAlignment)->ArgNames({"isa", "offset"})->ArgsProduct({ISAS, {0, 1, 8, 17, 31, 63}});
+
+BENCHMARK(BM_CountDensity)->ArgNames({"isa", "density"})->ArgsProduct({ISAS, {0, 1, 10, 50, 100}});
+
+BENCHMARK(BM_CountThreads)->ThreadRange(1, static_cast<int>(std::max(1U, std::thread::hardware_concurrency())));
+
+BENCHMARK(BM_CountBlock)
+    ->ArgNames({"characters", "size"})
+    ->ArgsProduct({{1, 2, 4, 8, 16, 64, 256}, {64 * 1024, 1024 * 1024}});
@@ -0,0 +1,216 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <boost/json/object.hpp>
+#include <boost/json/parse.hpp>
+#include <boost/json/value.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "dto/CountDto.hpp"
+#include "dto/JsonArena.hpp"
+
+// Allocations of the whole program, read around the benchmark loop only
+std::atomic<std::size_t> allocations_count{0};
+std::atomic<std::size_t> allocated_bytes{0};
+
+void* operator new(std::size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+namespace json = boost::json;
+namespace uuids = boost::uuids;
+
+/**
+ * @brief Count request as it was parsed before CountDto, the data is copied out of the document
+ */
+struct CopiedCountDto {
+    uuids::uuid id;
+    std::string data;
+};
+
+/**
+ * @brief Parses the request the same way as the server did before CountDto
+ *
+ * @param body Request body
+ * @param copied_bytes Incremented by the bytes of the data copied by every step
+ */
+CopiedCountDto parseCopy(std::string_view body, std::size_t& copied_bytes) {
+    boost::system::error_code ec;
+    json::value json_body = json::parse(body, ec);
+
+    if (ec || !json_body.is_object()) {
+        throw std::runtime_error("Request body is not in valid json format");
+    }
+
+    auto obj_body = json_body.as_object();
+
+    if (!obj_body.contains("id") || !obj_body.contains("data") || !obj_body.at("id").is_string() ||
+        !obj_body.at("data").is_string()) {
+        throw std::runtime_error("Request body is not valid json object");
+    }
+
+    auto id_value = obj_body.at("id");
+    auto data_value = obj_body.at("data");
+
+    CopiedCountDto result;
+    result.id = boost::lexical_cast<uuids::uuid>(id_value.as_string().c_str());
+    result.data = data_value.as_string().c_str();
+
+    // Data is copied by the parser into the document, with the object, with the value and into the result
+    copied_bytes += 4 * result.data.size();
+
+    return result;
+}
+
+std::string createBody(std::size_t data_size) {
+    std::string data(data_size, ' ');
+
+    for (std::size_t i = 0; i < data_size; ++i) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+
+    return R"({"id":"1b4e28ba-2fa1-11d2-883f-b9a761bde3fb","data":")" + data + R"("})";
+}
+
+/**
+ * @brief Returns true if the data is a view into the request body, so it was not copied
+ */
+bool isInBody(std::string_view data, std::string const& body) noexcept {
+    std::less<char const*> const less;
+    return !less(data.data(), body.data()) && !less(body.data() + body.size(), data.data() + data.size());
+}
+
+/**
+ * @brief Reports bytes of the data which are copied out of the request body, per request
+ */
+void reportCopiedBytes(benchmark::State& state, std::size_t copied_bytes) {
+    state.counters["copied_bytes_per_request"] =
+        benchmark::Counter(static_cast<double>(copied_bytes), benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * @brief Measures allocations of the benchmark loop and reports them per request
+ */
+class AllocationCounter {
+public:
+    AllocationCounter()
+        : allocations_count_{allocations_count.load(std::memory_order_relaxed)},
+          allocated_bytes_{allocated_bytes.load(std::memory_order_relaxed)} {}
+
+    void report(benchmark::State& state) const {
+        auto const allocations = allocations_count.load(std::memory_order_relaxed) - allocations_count_;
+        auto const bytes = allocated_bytes.load(std::memory_order_relaxed) - allocated_bytes_;
+
+        state.counters["allocs_per_request"] =
+            benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+        state.counters["alloc_bytes_per_request"] =
+            benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    std::size_t allocations_count_;
+    std::size_t allocated_bytes_;
+};
+
+/**
+ * @brief Parsing with the default allocator, the body object and "data" are copied (before)
+ */
+void BM_ParseCountDtoCopy(benchmark::State& state) {
+    auto const body = createBody(static_cast<std::size_t>(state.range(0)));
+
+    AllocationCounter allocation_counter;
+
+    std::size_t copied_bytes = 0;
+
+    for (auto _ : state) {
+        auto dto = parseCopy(body, copied_bytes);
+        benchmark::DoNotOptimize(dto.data.data());
+    }
+
+    allocation_counter.report(state);
+    reportCopiedBytes(state, copied_bytes);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+}
+
+/**
+ * @brief CountDto::parse with the default storage, data is a view into the request body
+ */
+void BM_ParseCountDtoDefault(benchmark::State& state) {
+    auto const body = createBody(static_cast<std::size_t>(state.range(0)));
+
+    AllocationCounter allocation_counter;
+
+    for (auto _ : state) {
+        auto dto = dto::CountDto::parse(body);
+
+        // Data without escapes must not be copied
+        if (!isInBody(dto.getData(), body)) {
+            state.SkipWithError("Data is copied out of the request body");
+            break;
+        }
+
+        benchmark::DoNotOptimize(dto.getData().data());
+    }
+
+    allocation_counter.report(state);
+    reportCopiedBytes(state, 0);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+}
+
+/**
+ * @brief CountDto::parse with a session arena which is reset for every request, same as in the server (after)
+ */
+void BM_ParseCountDtoArena(benchmark::State& state) {
+    auto const body = createBody(static_cast<std::size_t>(state.range(0)));
+
+    dto::JsonArena arena;
+    AllocationCounter allocation_counter;
+
+    for (auto _ : state) {
+        {
+            auto dto = dto::CountDto::parse(body, arena.storage());
+
+            // Data without escapes must not be copied
+            if (!isInBody(dto.getData(), body)) {
+                state.SkipWithError("Data is copied out of the request body");
+                break;
+            }
+
+            benchmark::DoNotOptimize(dto.getData().data());
+        }
+
+        arena.reset();
+    }
+
+    allocation_counter.report(state);
+    reportCopiedBytes(state, 0);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParseCountDtoCopy)->ArgName("size")->RangeMultiplier(16)->Range(64, 1024 * 1024);
+BENCHMARK(BM_ParseCountDtoDefault)->ArgName("size")->RangeMultiplier(16)->Range(64, 1024 * 1024);
+BENCHMARK(BM_ParseCountDtoArena)->ArgName("size")->RangeMultiplier(16)->Range(64, 1024 * 1024);
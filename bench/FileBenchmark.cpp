@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FileCounter.hpp"
+#include "SyntheticData.hpp"
+
+using namespace bench;
+
+namespace {
+
+std::vector<long> const IO_BACKENDS{static_cast<long>(IoBackend::stream), static_cast<long>(IoBackend::mmap),
+                                    static_cast<long>(IoBackend::uring)};
+
+char const* toString(IoBackend io_backend) noexcept {
+    switch (io_backend) {
+        case IoBackend::automatic:
+            return "auto";
+        case IoBackend::mmap:
+            return "mmap";
+        case IoBackend::stream:
+            return "stream";
+        case IoBackend::uring:
+            return "uring";
+    }
+
+    return "";
+}
+
+/**
+ * @brief Throughput of counting a page cache hot file by input backend, file size and thread count
+ */
+void BM_FileCounter(benchmark::State& state) {
+    auto const io_backend = static_cast<IoBackend>(state.range(0));
+    auto const size = static_cast<std::size_t>(state.range(1));
+    auto const threads_count = static_cast<unsigned>(state.range(2));
+
+    state.SetLabel(toString(io_backend));
+
+    std::vector<InputFile> const files{{getSyntheticFile(size).string(), true, size}};
+
+    counter::CharacterSet characters;
+    characters.insert(MATCH_CHARACTER);
+
+    FileCounter file_counter{threads_count, characters, io_backend};
+
+    for (auto _ : state) {
+        auto results = file_counter.count(files);
+
+        if (results.front().error) {
+            state.SkipWithError(results.front().error->c_str());
+            break;
+        }
+
+        benchmark::DoNotOptimize(results);
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+}
+
+std::vector<long> getThreadCounts() {
+    std::vector<long> result;
+
+    auto const hardware_threads = static_cast<long>(std::max(1U, std::thread::hardware_concurrency()));
+
+    for (long threads_count = 1; threads_count < hardware_threads; threads_count *= 2) {
+        result.push_back(threads_count);
+    }
+
+    result.push_back(hardware_threads);
+    return result;
+}
+
+}  // namespace
+
+BENCHMARK(BM_FileCounter)
+    ->ArgNames({"backend", "size", "threads"})
+    ->ArgsProduct({IO_BACKENDS, {1024 * 1024, 64 * 1024 * 1024, 256 * 1024 * 1024}, getThreadCounts()})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
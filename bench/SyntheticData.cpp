@@ -0,0 +1,107 @@
+#include "SyntheticData.hpp"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace bench {
+
+// Matching density of the synthetic files
+auto constexpr FILE_DENSITY{1U};
+
+namespace {
+
+std::string makeData(std::size_t size, unsigned density) {
+    // xorshift64, cheap enough to generate hundreds of megabytes
+    std::uint64_t state = 0x9E3779B97F4A7C15ULL ^ size;
+
+    std::string data(size, '\0');
+
+    for (auto& c : data) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        c = (state >> 32) % 100 < density ? MATCH_CHARACTER : static_cast<char>('a' + (state & 0xFFFF) % 26);
+    }
+
+    return data;
+}
+
+/**
+ * @brief Synthetic files which are removed at exit
+ */
+class SyntheticFiles {
+public:
+    ~SyntheticFiles() {
+        for (auto const& [size, path] : files_) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    fs::path get(std::size_t size) {
+        std::lock_guard lock{mutex_};
+
+        if (auto const it = files_.find(size); it != files_.end()) {
+            return it->second;
+        }
+
+        auto const path =
+            fs::temp_directory_path() / ("chcount_bench_" + std::to_string(::getpid()) + "_" + std::to_string(size));
+
+        {
+            auto const& data = getSyntheticData(size, FILE_DENSITY);
+            std::ofstream fout{path, std::ios_base::binary};
+            fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+            if (!fout) {
+                throw std::runtime_error("Cannot write synthetic file " + path.string());
+            }
+        }
+
+        // Reading the file puts it into the page cache, benchmarks measure the hot reads
+        std::ifstream fin{path, std::ios_base::binary};
+        std::string buffer(1024 * 1024, '\0');
+        while (fin.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+        }
+
+        files_.emplace(size, path);
+        return path;
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::size_t, fs::path> files_;
+};
+
+}  // namespace
+
+std::string const& getSyntheticData(std::size_t size, unsigned density) {
+    static std::mutex mutex;
+    static std::map<std::pair<std::size_t, unsigned>, std::string> data;
+
+    std::lock_guard lock{mutex};
+
+    auto it = data.find({size, density});
+
+    if (it == data.end()) {
+        it = data.emplace(std::pair{size, density}, makeData(size, density)).first;
+    }
+
+    return it->second;
+}
+
+fs::path getSyntheticFile(std::size_t size) {
+    static SyntheticFiles files;
+    return files.get(size);
+}
+
+}  // namespace bench
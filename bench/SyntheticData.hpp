@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+namespace bench {
+
+// Counted character, the other bytes never match it
+auto constexpr MATCH_CHARACTER{'I'};
+
+/**
+ * @brief Returns printable data in which the given percent of bytes are MATCH_CHARACTER.
+ * Data is deterministic, so runs of the benchmarks are comparable. Data is generated on the first call
+ * and shared by all calls with the same arguments.
+ *
+ * @param size Data size in bytes
+ * @param density Percent of the matching bytes, from 0 to 100
+ * @return Data
+ */
+std::string const& getSyntheticData(std::size_t size, unsigned density);
+
+/**
+ * @brief Returns path of the synthetic file of the given size in the temporary directory.
+ * File is created on the first call and read once, so it is in the page cache. Files are removed at exit.
+ *
+ * @param size File size in bytes
+ * @return File path
+ */
+std::filesystem::path getSyntheticFile(std::size_t size);
+
+}  // namespace bench
@@ -0,0 +1,142 @@
+#include "Worker.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#include "Counter.hpp"
+#include "FileCounter.hpp"
+#include "WorkerProtocol.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * @brief Reads exactly size bytes from the file descriptor
+ *
+ * @return Number of bytes read, less than size only at the end of the input
+ */
+std::size_t readFull(int fd, char* data, std::size_t size) {
+    std::size_t done = 0;
+
+    while (done < size) {
+        auto const result = ::read(fd, data + done, size - done);
+
+        if (result == 0) {
+            break;
+        }
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+
+        done += static_cast<std::size_t>(result);
+    }
+
+    return done;
+}
+
+void writeFull(int fd, std::string_view data) {
+    while (!data.empty()) {
+        auto const result = ::write(fd, data.data(), data.size());
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+
+        data.remove_prefix(static_cast<std::size_t>(result));
+    }
+}
+
+worker::Response handleRequest(worker::Request const& request) {
+    if (request.type == worker::RequestType::ping) {
+        return {worker::Status::pong, {}, {}};
+    }
+
+    counter::Histogram counts{};
+
+    if (request.type == worker::RequestType::data) {
+        counter::countBlock(request.payload, request.characters, counts);
+    } else {
+        std::string const path{request.payload};
+
+        std::error_code ec;
+        auto const size = fs::file_size(path, ec);
+
+        if (ec) {
+            return {worker::Status::error, {}, path + ": " + ec.message()};
+        }
+
+        // Workers run in parallel, so every worker counts on its own thread only
+        FileCounter file_counter{1, request.characters, IoBackend::automatic};
+        auto result = file_counter.count({{path, true, size}});
+
+        if (result.front().error) {
+            return {worker::Status::error, {}, path + ": " + *result.front().error};
+        }
+
+        counts = result.front().counts;
+    }
+
+    worker::Response response{worker::Status::ok, {}, {}};
+    for (auto const c : request.characters.characters()) {
+        response.counts.push_back(counts[static_cast<unsigned char>(c)]);
+    }
+
+    return response;
+}
+
+}  // namespace
+
+int runWorker() {
+    std::string frame;
+
+    try {
+        while (true) {
+            char prefix[worker::FRAME_PREFIX_SIZE];
+            auto const prefix_size = readFull(STDIN_FILENO, prefix, sizeof(prefix));
+
+            // Server closed the pipe
+            if (prefix_size == 0) {
+                return EXIT_SUCCESS;
+            }
+
+            auto const frame_size = worker::decodeFrameSize(prefix);
+
+            if (prefix_size != sizeof(prefix) || frame_size > worker::MAX_FRAME_SIZE) {
+                std::cerr << "Error: Malformed request frame" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            frame.resize(frame_size);
+            if (readFull(STDIN_FILENO, frame.data(), frame.size()) != frame.size()) {
+                std::cerr << "Error: Truncated request frame" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            worker::Response response;
+            try {
+                response = handleRequest(worker::decodeRequest(frame));
+            } catch (std::exception const& e) {
+                response = {worker::Status::error, {}, e.what()};
+            }
+
+            writeFull(STDOUT_FILENO, worker::encodeResponse(response));
+        }
+    } catch (std::system_error const& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
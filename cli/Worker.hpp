@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @brief Runs chcount as a long-lived worker. Reads framed requests (see WorkerProtocol.hpp)
+ * from the standard input and writes framed responses to the standard output until the
+ * standard input is closed.
+ *
+ * @return Process exit code
+ */
+int runWorker();
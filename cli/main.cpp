@@ -1,18 +1,36 @@
+#include <glob.h>
+
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/program_options.hpp>
 #include <filesystem>
-#include <fstream>
-#include <future>
 #include <iostream>
 #include <iterator>
-#include <numeric>
+#include <string>
+#include <system_error>
 #include <thread>
+#include <vector>
+
+#include "Counter.hpp"
+#include "FileCounter.hpp"
+#include "Worker.hpp"
+
+using Histogram = counter::Histogram;
 
-using FutureUintmax = std::future<std::uintmax_t>;
+enum class OutputFormat { text, json };
 
 struct Options {
-    char character;
-    std::string file_path;
+    counter::CharacterSet characters;
+    bool histogram;
+    bool recursive;
+    std::vector<InputFile> inputs;
+    // Result is printed per input with total when more than one input is given or expanded
+    bool multiple_inputs;
+    IoBackend io_backend;
+    OutputFormat output_format;
+    unsigned threads_count;
+    // Run as a long-lived server worker, the other options are ignored
+    bool worker;
 };
 
 /**
@@ -26,99 +44,192 @@ struct Options {
 Options parseArgumentOptions(int argc, char** argv);
 
 /**
- * @brief Returns the number of elements in ragne [first, first+n) which are
- * equal to value if first+n not exeeds last, otherwise instead of [first,
- * first+n) range is [first, last).
+ * @brief Prints counts of the requested characters of a single input in the requested format
  *
- * @tparam InputIt Input iterator
- * @tparam T Value type
- * @param first Iterator to first element
- * @param last Iterator to last element
- * @param n Number of elements to check
- * @param value Value which we count
- * @return Value occurence count
+ * @param out Output stream
+ * @param result Counts
+ * @param options Options
  */
-template <class InputIt, typename T>
-std::uint64_t count_if_n(InputIt first, InputIt last, std::uint64_t n, T const& value);
+void printResult(std::ostream& out, Histogram const& result, Options const& options);
 
 /**
- * @brief Create a Worker object function
+ * @brief Prints counts of every input and the total counts in the requested format
  *
- * @param star_pos Start position for counting the characters
- * @param chunk_size Size of the chunk on which worker searches
+ * @param out Output stream
+ * @param results Results in the order of the inputs
  * @param options Options
- * @return std::function<uintmax_t()> Function which counts character on specific part of the file
  */
-std::function<uintmax_t()> createWorker(std::uintmax_t start_pos, std::uintmax_t chunk_size, Options options);
+void printResults(std::ostream& out, std::vector<FileResult> const& results, Options const& options);
 
 int main(int argc, char** argv) {
     auto const options = parseArgumentOptions(argc, argv);
 
-    auto const file_size = std::filesystem::file_size(options.file_path);
+    if (options.worker) {
+        return runWorker();
+    }
 
-    auto threads_count = std::thread::hardware_concurrency() - 1;
+    FileCounter file_counter{options.threads_count, options.characters, options.io_backend};
+    auto const results = file_counter.count(options.inputs);
 
-    std::uintmax_t result = 0;
+    bool failed = false;
 
-    if (threads_count == 0 || file_size <= threads_count) {  // Single thread or file too small for separation
-        std::ifstream fin(options.file_path);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        if (results[i].error) {
+            std::cerr << "Error: " << options.inputs[i].path << ": " << *results[i].error << std::endl;
+            failed = true;
+        }
+    }
 
-        result = std::count_if(std::istream_iterator<char>(fin), std::istream_iterator<char>(),
-                               [&options](char c) { return c == options.character; });
-    } else {  // Multithread
-        auto per_thread_chunk_size = file_size / threads_count;
-        auto leftover_bytes = file_size % threads_count;
+    if (options.multiple_inputs) {
+        printResults(std::cout, results, options);
+    } else if (!failed) {
+        printResult(std::cout, results.front().counts, options);
+    }
 
-        std::vector<FutureUintmax> workers;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// DEFINITIONS
 
-        for (unsigned i = 0; i < threads_count; ++i) {
-            auto const chunk_size = per_thread_chunk_size + (i != threads_count - 1 ? 0 : leftover_bytes);
+namespace po = boost::program_options;
+namespace fs = std::filesystem;
 
-            auto worker = std::async(std::launch::async, createWorker(i * per_thread_chunk_size, chunk_size, options));
+// Input file path which stands for the standard input
+auto constexpr STDIN_PATH{"-"};
 
-            workers.emplace_back(std::move(worker));
-        }
+/**
+ * @brief Returns printable representation of the character, non printable
+ * characters and space are written as \xNN
+ */
+std::string toPrintable(char c) {
+    auto const value = static_cast<unsigned char>(c);
 
-        std::vector<std::uintmax_t> worker_results(workers.size(), 0ULL);
+    if (value > ' ' && value < 0x7F) {
+        return std::string(1, c);
+    }
 
-        // Wait for workers to finish and save results
-        std::transform(workers.begin(), workers.end(), worker_results.begin(), std::mem_fn(&FutureUintmax::get));
+    return (boost::format("\\x%02X") % static_cast<unsigned>(value)).str();
+}
 
-        // Calculate sum of characters
-        result = std::accumulate(worker_results.cbegin(), worker_results.cend(), 0ULL);
+/**
+ * @brief Returns string as JSON string literal, bytes above ASCII are copied as they are
+ */
+std::string toJsonString(std::string_view s) {
+    std::string result{'"'};
+
+    for (auto const c : s) {
+        auto const value = static_cast<unsigned char>(c);
+
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (value < ' ' || value == 0x7F) {
+            result += (boost::format("\\u%04X") % static_cast<unsigned>(value)).str();
+        } else {
+            result += c;
+        }
     }
 
-    std::cout << result << std::endl;
+    result += '"';
+    return result;
+}
+
+/**
+ * @brief Returns character as JSON string literal
+ */
+std::string toJsonString(char c) {
+    auto const value = static_cast<unsigned char>(c);
+
+    // Bytes outside of ASCII are written as U+0080 - U+00FF code points
+    if (value > 0x7F) {
+        return (boost::format("\"\\u%04X\"") % static_cast<unsigned>(value)).str();
+    }
 
-    return EXIT_SUCCESS;
+    return toJsonString(std::string_view{&c, 1});
 }
 
-// DEFINITIONS
+/**
+ * @brief Returns counts of the requested characters as JSON object
+ */
+std::string toJsonObject(Histogram const& result, Options const& options) {
+    auto const& characters = options.characters.characters();
 
-namespace po = boost::program_options;
+    std::string json{'{'};
+    for (std::size_t i = 0; i < characters.size(); ++i) {
+        json += (i != 0 ? "," : "") + toJsonString(characters[i]) + ":" +
+                std::to_string(result[static_cast<unsigned char>(characters[i])]);
+    }
+    json += '}';
+
+    return json;
+}
 
-std::mutex mutex;
+void printResult(std::ostream& out, Histogram const& result, Options const& options) {
+    auto const& characters = options.characters.characters();
 
-template <typename InputIt, typename T>
-std::uintmax_t count_if_n(InputIt first, InputIt last, std::uintmax_t n, T const& value) {
-    std::uintmax_t result = 0;
-    std::uintmax_t i = 0;
+    if (options.output_format == OutputFormat::json) {
+        out << toJsonObject(result, options) << std::endl;
+        return;
+    }
 
-    for (; first != last && i < n; ++first, ++i) {
-        if (*first == value) ++result;
+    // Single character is printed as plain number
+    if (!options.histogram && characters.size() == 1) {
+        out << result[static_cast<unsigned char>(characters.front())] << std::endl;
+        return;
     }
 
-    return result;
+    for (auto const c : characters) {
+        out << toPrintable(c) << " " << result[static_cast<unsigned char>(c)] << "\n";
+    }
+    out << std::flush;
 }
 
-std::function<uintmax_t()> createWorker(std::uintmax_t start_pos, std::uintmax_t chunk_size, Options options) {
-    return [start_pos, chunk_size, file_path = options.file_path, c = options.character]() {
-        std::ifstream fin{file_path};
-        fin.unsetf(std::ios_base::skipws);
-        fin.seekg(start_pos);
+void printResults(std::ostream& out, std::vector<FileResult> const& results, Options const& options) {
+    Histogram total{};
+    for (auto const& result : results) {
+        kernel::merge(total, result.counts);
+    }
 
-        return count_if_n(std::istream_iterator<char>(fin), std::istream_iterator<char>(), chunk_size, c);
-    };
+    if (options.output_format == OutputFormat::json) {
+        out << "{\"files\":[";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            out << (i != 0 ? "," : "") << "{\"path\":" << toJsonString(options.inputs[i].path) << ",";
+
+            if (results[i].error) {
+                out << "\"error\":" << toJsonString(*results[i].error) << "}";
+            } else {
+                out << "\"counts\":" << toJsonObject(results[i].counts, options) << "}";
+            }
+        }
+        out << "],\"total\":" << toJsonObject(total, options) << "}" << std::endl;
+        return;
+    }
+
+    auto const& characters = options.characters.characters();
+
+    // Single character is printed as "count path" lines, same as wc prints
+    if (!options.histogram && characters.size() == 1) {
+        auto const index = static_cast<unsigned char>(characters.front());
+
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (!results[i].error) {
+                out << results[i].counts[index] << " " << options.inputs[i].path << "\n";
+            }
+        }
+        out << total[index] << " total" << std::endl;
+        return;
+    }
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].error) {
+            out << options.inputs[i].path << "\n";
+            printResult(out, results[i].counts, options);
+            out << "\n";
+        }
+    }
+
+    out << "total\n";
+    printResult(out, total, options);
 }
 
 void exitWithError(std::string const& error_message, po::options_description const& desc) {
@@ -128,15 +239,125 @@ void exitWithError(std::string const& error_message, po::options_description con
     exit(EXIT_FAILURE);
 }
 
+/**
+ * @brief Returns paths matching the glob pattern in sorted order
+ */
+std::vector<std::string> expandGlob(std::string const& pattern) {
+    std::vector<std::string> result;
+
+    glob_t matches{};
+    if (::glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+        result.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+    ::globfree(&matches);
+
+    return result;
+}
+
+/**
+ * @brief Expands input path arguments into inputs. Glob patterns are expanded and
+ * directories are walked when recursive is set.
+ *
+ * @param paths Input path arguments
+ * @param options Options, inputs and multiple_inputs are set
+ * @param desc Options description for the error message
+ */
+void collectInputs(std::vector<std::string> const& paths, Options& options, po::options_description const& desc) {
+    options.multiple_inputs = paths.size() > 1;
+
+    auto const add_file = [&options, &desc](std::string const& path) {
+        auto const status = fs::status(path);
+
+        if (fs::is_regular_file(status)) {
+            options.inputs.push_back({path, true, fs::file_size(path)});
+        } else if (fs::is_fifo(status) || fs::is_character_file(status)) {
+            options.inputs.push_back({path, false, 0});
+        } else {
+            exitWithError((boost::format("\"%1%\" is not a regular file, FIFO or character device") % path).str(),
+                          desc);
+        }
+    };
+
+    for (auto const& path : paths) {
+        if (path == STDIN_PATH) {
+            options.inputs.push_back({path, false, 0});
+            continue;
+        }
+
+        // Pattern which wasn't expanded by the shell (quoted or too many files for the command line)
+        if (!fs::exists(path) && path.find_first_of("*?[") != std::string::npos) {
+            auto const matches = expandGlob(path);
+
+            // Same as the recursive walk, matched FIFOs and devices could block forever and directories are
+            // skipped, only inputs named explicitly can be other than regular files
+            std::vector<std::string> files;
+            std::copy_if(matches.cbegin(), matches.cend(), std::back_inserter(files), [](std::string const& match) {
+                std::error_code ec;
+                return fs::is_regular_file(match, ec);
+            });
+
+            if (files.empty()) {
+                exitWithError((boost::format("Pattern \"%1%\" doesn't match any regular file") % path).str(), desc);
+            }
+
+            options.multiple_inputs = true;
+            std::for_each(files.cbegin(), files.cend(), add_file);
+            continue;
+        }
+
+        if (!fs::exists(path)) {
+            exitWithError((boost::format("Input file \"%1%\" doesn't exist") % path).str(), desc);
+        }
+
+        if (fs::is_directory(path)) {
+            if (!options.recursive) {
+                exitWithError((boost::format("\"%1%\" is a directory, use --recursive") % path).str(), desc);
+            }
+
+            std::vector<std::string> files;
+            for (auto const& entry :
+                 fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied)) {
+                // FIFOs and devices found by the walk could block forever
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path().string());
+                }
+            }
+            std::sort(files.begin(), files.end());
+
+            options.multiple_inputs = true;
+            std::for_each(files.cbegin(), files.cend(), add_file);
+            continue;
+        }
+
+        add_file(path);
+    }
+}
+
 Options parseArgumentOptions(int argc, char** argv) {
     Options result;
+    std::vector<char> characters;
+    std::vector<std::string> input_paths;
+    std::string io_backend;
+    std::string output_format;
+    auto const default_threads_count = std::max(std::thread::hardware_concurrency(), 1U);
 
     po::options_description desc("Options");
 
     // clang-format off
     desc.add_options()
-        ("help", "Help message")("character,c", po::value<char>(&result.character),"Character which we count")
-        ("input-file,f", po::value<std::string>(&result.file_path), "Path to an input file");
+        ("help", "Help message")
+        ("character,c", po::value<std::vector<char>>(&characters)->composing(),
+            "Character which we count, can be given multiple times")
+        ("histogram", po::bool_switch(&result.histogram), "Count all 256 byte values")
+        ("input-file,f", po::value<std::vector<std::string>>(&input_paths)->composing(),
+            "Path to an input file, directory or glob pattern, - for standard input. Can be given multiple times")
+        ("recursive,r", po::bool_switch(&result.recursive), "Count all files in input directories recursively")
+        ("format", po::value<std::string>(&output_format)->default_value("text"), "Output format: text or json")
+        ("io", po::value<std::string>(&io_backend)->default_value("auto"), "Input backend: auto, mmap, stream or uring")
+        ("threads,t", po::value<unsigned>(&result.threads_count)->default_value(default_threads_count),
+            "Number of counting threads")
+        ("worker", po::bool_switch(&result.worker),
+            "Run as a server worker, reads framed requests from the standard input");
     // clang-format on
 
     try {
@@ -149,22 +370,57 @@ Options parseArgumentOptions(int argc, char** argv) {
             exit(EXIT_SUCCESS);
         }
 
-        if (!vm.count("character")) {
+        if (result.worker) {
+            return result;
+        }
+
+        if (!vm.count("character") && !result.histogram) {
             exitWithError("Character not provided", desc);
         }
 
+        if (result.histogram) {
+            result.characters = counter::CharacterSet::all();
+        } else {
+            std::for_each(characters.cbegin(), characters.cend(),
+                          [&result](char c) { result.characters.insert(c); });
+        }
+
         if (!vm.count("input-file")) {
             exitWithError("Input file path not provided", desc);
         }
 
-        if (!std::filesystem::exists(result.file_path)) {
-            auto const msg = (boost::format("Input file \"%1%\" doesn't exist") % result.file_path).str();
-            exitWithError(msg, desc);
+        if (std::count(input_paths.cbegin(), input_paths.cend(), STDIN_PATH) > 1) {
+            exitWithError("Standard input can be given only once", desc);
+        }
+
+        collectInputs(input_paths, result, desc);
+
+        if (result.inputs.empty()) {
+            exitWithError("No input files found", desc);
+        }
+
+        if (result.threads_count == 0) {
+            exitWithError("Number of threads must be positive", desc);
+        }
+
+        if (io_backend == "auto") {
+            result.io_backend = IoBackend::automatic;
+        } else if (io_backend == "mmap") {
+            result.io_backend = IoBackend::mmap;
+        } else if (io_backend == "stream") {
+            result.io_backend = IoBackend::stream;
+        } else if (io_backend == "uring") {
+            result.io_backend = IoBackend::uring;
+        } else {
+            exitWithError((boost::format("Unknown input backend \"%1%\"") % io_backend).str(), desc);
         }
 
-        if (!std::filesystem::is_regular_file(result.file_path)) {
-            auto const msg = (boost::format("\"%1%\" is not a regular file") % result.file_path).str();
-            exitWithError(msg, desc);
+        if (output_format == "text") {
+            result.output_format = OutputFormat::text;
+        } else if (output_format == "json") {
+            result.output_format = OutputFormat::json;
+        } else {
+            exitWithError((boost::format("Unknown output format \"%1%\"") % output_format).str(), desc);
         }
 
         return result;
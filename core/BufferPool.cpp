@@ -0,0 +1,63 @@
+#include "BufferPool.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::size_t pageSize() noexcept {
+    static auto const page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+}  // namespace
+
+BufferPool::BufferPool(std::size_t buffers_count, std::size_t buffer_size)
+    : buffer_size_{(buffer_size + pageSize() - 1) / pageSize() * pageSize()} {
+    buffers_.reserve(buffers_count);
+    free_.reserve(buffers_count);
+
+    for (std::size_t i = 0; i < buffers_count; ++i) {
+        // Page alignment makes buffers usable for O_DIRECT reads
+        auto* const p = static_cast<char*>(std::aligned_alloc(pageSize(), buffer_size_));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        buffers_.emplace_back(p);
+        free_.push_back(buffers_count - i - 1);
+    }
+}
+
+std::size_t BufferPool::acquire() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return !free_.empty(); });
+
+    auto const index = free_.back();
+    free_.pop_back();
+    return index;
+}
+
+bool BufferPool::tryAcquire(std::size_t& index) {
+    std::lock_guard lock{mutex_};
+
+    if (free_.empty()) {
+        return false;
+    }
+
+    index = free_.back();
+    free_.pop_back();
+    return true;
+}
+
+void BufferPool::release(std::size_t index) {
+    {
+        std::lock_guard lock{mutex_};
+        free_.push_back(index);
+    }
+    cv_.notify_one();
+}
+
+void BufferPool::Deleter::operator()(char* p) const noexcept { std::free(p); }
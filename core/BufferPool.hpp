@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Fixed number of equally sized, page aligned buffers shared between
+ * a reader and counting workers. Reader acquires free buffers and fills them,
+ * workers release them after counting, so memory use is bounded by the pool
+ * size and not by the input size.
+ */
+class BufferPool {
+public:
+    /**
+     * @brief Allocates buffers_count buffers of buffer_size bytes
+     *
+     * @param buffers_count Number of buffers
+     * @param buffer_size Size of a single buffer, rounded up to the page size
+     */
+    BufferPool(std::size_t buffers_count, std::size_t buffer_size);
+
+    BufferPool(BufferPool const&) = delete;
+    BufferPool& operator=(BufferPool const&) = delete;
+
+    std::size_t count() const noexcept { return buffers_.size(); }
+    std::size_t bufferSize() const noexcept { return buffer_size_; }
+
+    char* data(std::size_t index) const noexcept { return buffers_[index].get(); }
+
+    /**
+     * @brief Waits until some buffer is free and takes it
+     *
+     * @return Buffer index
+     */
+    std::size_t acquire();
+
+    /**
+     * @brief Takes free buffer if there is one
+     *
+     * @param index Taken buffer index
+     * @return True if buffer is taken
+     */
+    bool tryAcquire(std::size_t& index);
+
+    /**
+     * @brief Returns buffer to the pool
+     *
+     * @param index Buffer index
+     */
+    void release(std::size_t index);
+
+private:
+    struct Deleter {
+        void operator()(char* p) const noexcept;
+    };
+
+    std::size_t buffer_size_;
+    std::vector<std::unique_ptr<char, Deleter>> buffers_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::size_t> free_;
+};
@@ -0,0 +1,179 @@
+#include "CountKernel.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHCOUNT_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// 8-bit lane accumulators overflow after 255 compare steps
+auto constexpr MAX_ACCUMULATE_STEPS{255U};
+
+}  // namespace
+
+std::uint64_t kernel::countScalar(char const* data, std::size_t size, char value) noexcept {
+    std::uint64_t result = 0;
+
+    for (std::size_t i = 0; i < size; ++i) {
+        result += (data[i] == value);
+    }
+
+    return result;
+}
+
+#ifdef CHCOUNT_X86
+
+__attribute__((target("sse2"))) std::uint64_t kernel::countSse2(char const* data, std::size_t size,
+                                                                char value) noexcept {
+    auto const needle = _mm_set1_epi8(value);
+    auto const zero = _mm_setzero_si128();
+
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+
+    while (size - i >= sizeof(__m128i)) {
+        auto const steps = std::min<std::size_t>((size - i) / sizeof(__m128i), MAX_ACCUMULATE_STEPS);
+
+        // Matching lanes are 0xFF (-1), so subtracting the mask increments the lane counter
+        auto acc = zero;
+        for (std::size_t step = 0; step < steps; ++step, i += sizeof(__m128i)) {
+            auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(chunk, needle));
+        }
+
+        alignas(16) std::uint64_t sums[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), _mm_sad_epu8(acc, zero));
+        result += sums[0] + sums[1];
+    }
+
+    return result + countScalar(data + i, size - i, value);
+}
+
+__attribute__((target("avx2"))) std::uint64_t kernel::countAvx2(char const* data, std::size_t size,
+                                                                char value) noexcept {
+    auto const needle = _mm256_set1_epi8(value);
+    auto const zero = _mm256_setzero_si256();
+
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+
+    while (size - i >= sizeof(__m256i)) {
+        auto const steps = std::min<std::size_t>((size - i) / sizeof(__m256i), MAX_ACCUMULATE_STEPS);
+
+        auto acc = zero;
+        for (std::size_t step = 0; step < steps; ++step, i += sizeof(__m256i)) {
+            auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(chunk, needle));
+        }
+
+        alignas(32) std::uint64_t sums[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_sad_epu8(acc, zero));
+        result += sums[0] + sums[1] + sums[2] + sums[3];
+    }
+
+    return result + countScalar(data + i, size - i, value);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt"))) std::uint64_t kernel::countAvx512(char const* data,
+                                                                                     std::size_t size,
+                                                                                     char value) noexcept {
+    auto const needle = _mm512_set1_epi8(value);
+
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+
+    for (; size - i >= sizeof(__m512i); i += sizeof(__m512i)) {
+        auto const chunk = _mm512_loadu_si512(data + i);
+        result += __builtin_popcountll(_mm512_cmpeq_epi8_mask(chunk, needle));
+    }
+
+    // Masked load never touches bytes past the end of data
+    if (auto const rest = size - i; rest != 0) {
+        auto const mask = (__mmask64{1} << rest) - 1;
+        auto const chunk = _mm512_maskz_loadu_epi8(mask, data + i);
+        result += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(mask, chunk, needle));
+    }
+
+    return result;
+}
+
+bool kernel::isSupported(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::scalar:
+            return true;
+        case Isa::sse2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::avx2:
+            return __builtin_cpu_supports("avx2");
+        case Isa::avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                   __builtin_cpu_supports("popcnt");
+    }
+
+    return false;
+}
+
+#else
+
+std::uint64_t kernel::countSse2(char const* data, std::size_t size, char value) noexcept {
+    return countScalar(data, size, value);
+}
+
+std::uint64_t kernel::countAvx2(char const* data, std::size_t size, char value) noexcept {
+    return countScalar(data, size, value);
+}
+
+std::uint64_t kernel::countAvx512(char const* data, std::size_t size, char value) noexcept {
+    return countScalar(data, size, value);
+}
+
+bool kernel::isSupported(Isa isa) noexcept { return isa == Isa::scalar; }
+
+#endif
+
+kernel::Isa kernel::detectIsa() noexcept {
+    for (auto const isa : {Isa::avx512, Isa::avx2, Isa::sse2}) {
+        if (isSupported(isa)) return isa;
+    }
+
+    return Isa::scalar;
+}
+
+kernel::CountFunction kernel::getCountFunction(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::sse2:
+            return &countSse2;
+        case Isa::avx2:
+            return &countAvx2;
+        case Isa::avx512:
+            return &countAvx512;
+        case Isa::scalar:
+            break;
+    }
+
+    return &countScalar;
+}
+
+std::string_view kernel::toString(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::sse2:
+            return "sse2";
+        case Isa::avx2:
+            return "avx2";
+        case Isa::avx512:
+            return "avx512";
+        case Isa::scalar:
+            break;
+    }
+
+    return "scalar";
+}
+
+std::uint64_t kernel::count(std::string_view data, char value) noexcept {
+    static CountFunction const count_function = getCountFunction(detectIsa());
+
+    return count_function(data.data(), data.size(), value);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace kernel {
+
+/**
+ * @brief Instruction sets for which the counting kernel is implemented
+ */
+enum class Isa { scalar, sse2, avx2, avx512 };
+
+using CountFunction = std::uint64_t (*)(char const* data, std::size_t size, char value) noexcept;
+
+/**
+ * @brief Reference implementation which checks one byte at a time
+ *
+ * @param data Pointer to the first byte
+ * @param size Number of bytes to check
+ * @param value Value which we count
+ * @return Value occurence count
+ */
+std::uint64_t countScalar(char const* data, std::size_t size, char value) noexcept;
+
+/**
+ * @brief SSE2 compare and accumulate kernel (16 bytes per step)
+ */
+std::uint64_t countSse2(char const* data, std::size_t size, char value) noexcept;
+
+/**
+ * @brief AVX2 compare and accumulate kernel (32 bytes per step)
+ */
+std::uint64_t countAvx2(char const* data, std::size_t size, char value) noexcept;
+
+/**
+ * @brief AVX-512BW compare and popcount kernel (64 bytes per step, masked tail)
+ */
+std::uint64_t countAvx512(char const* data, std::size_t size, char value) noexcept;
+
+/**
+ * @brief Checks if the running CPU (and OS) supports the instruction set
+ *
+ * @param isa Instruction set
+ * @return True if kernel for isa can be executed
+ */
+bool isSupported(Isa isa) noexcept;
+
+/**
+ * @brief Returns the widest instruction set supported by the running CPU
+ */
+Isa detectIsa() noexcept;
+
+/**
+ * @brief Returns the kernel implementation for the instruction set
+ *
+ * @param isa Instruction set
+ * @return Kernel function
+ */
+CountFunction getCountFunction(Isa isa) noexcept;
+
+/**
+ * @brief Returns the instruction set name
+ */
+std::string_view toString(Isa isa) noexcept;
+
+/**
+ * @brief Counts occurences of value in data using the best kernel for the running CPU.
+ * Kernel is selected once, on the first call.
+ *
+ * @param data Data
+ * @param value Value which we count
+ * @return Value occurence count
+ */
+std::uint64_t count(std::string_view data, char value) noexcept;
+
+}  // namespace kernel
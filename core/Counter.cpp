@@ -0,0 +1,45 @@
+#include "Counter.hpp"
+
+#include <algorithm>
+
+#include "CountKernel.hpp"
+
+namespace {
+
+// Above this many characters histogram pass is faster than repeated vectorized passes
+auto constexpr VECTORIZED_PASSES_LIMIT{4U};
+
+}  // namespace
+
+counter::CharacterSet counter::CharacterSet::all() {
+    CharacterSet result;
+
+    for (unsigned value = 0; value < 256; ++value) {
+        result.insert(static_cast<char>(value));
+    }
+
+    return result;
+}
+
+void counter::CharacterSet::insert(char c) {
+    if (contains(c)) {
+        return;
+    }
+
+    mask_.set(static_cast<unsigned char>(c));
+
+    auto const by_byte_value = [](char lhs, char rhs) {
+        return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+    };
+    characters_.insert(std::upper_bound(characters_.begin(), characters_.end(), c, by_byte_value), c);
+}
+
+void counter::countBlock(std::string_view data, CharacterSet const& characters, Histogram& result) noexcept {
+    if (characters.size() <= VECTORIZED_PASSES_LIMIT) {
+        for (auto const c : characters.characters()) {
+            result[static_cast<unsigned char>(c)] += kernel::count(data, c);
+        }
+    } else {
+        kernel::histogram(data, result);
+    }
+}
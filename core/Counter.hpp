@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "HistogramKernel.hpp"
+
+namespace counter {
+
+using Histogram = kernel::Histogram;
+
+/**
+ * @brief Set of byte values which are counted
+ */
+class CharacterSet {
+public:
+    /**
+     * @brief Returns set of all 256 byte values
+     */
+    static CharacterSet all();
+
+    void insert(char c);
+
+    bool contains(char c) const noexcept { return mask_.test(static_cast<unsigned char>(c)); }
+    std::size_t size() const noexcept { return characters_.size(); }
+    bool empty() const noexcept { return characters_.empty(); }
+
+    /**
+     * @brief Returns characters of the set in ascending unsigned byte order
+     */
+    std::vector<char> const& characters() const noexcept { return characters_; }
+
+private:
+    std::bitset<256> mask_;
+    std::vector<char> characters_;
+};
+
+/**
+ * @brief Adds occurence counts of characters from the set in data to result.
+ * Counts of the other byte values in result are unspecified.
+ * Small sets are counted with one vectorized pass per character over the
+ * block (block stays in cache), bigger sets with a single histogram pass.
+ *
+ * @param data Data
+ * @param characters Characters which we count
+ * @param result Histogram to which counts are added
+ */
+void countBlock(std::string_view data, CharacterSet const& characters, Histogram& result) noexcept;
+
+}  // namespace counter
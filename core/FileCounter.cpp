@@ -0,0 +1,359 @@
+#include "FileCounter.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <system_error>
+
+#include "BufferPool.hpp"
+#include "UringReader.hpp"
+
+using Histogram = counter::Histogram;
+
+namespace {
+
+// Work unit of the scheduler, small enough to stay in L2 cache while it is counted
+auto constexpr CHUNK_SIZE{std::uintmax_t{1} << 20};
+
+// Number of io_uring reads in flight
+auto constexpr URING_QUEUE_DEPTH{8U};
+
+// Small files are batched until the batch reaches chunk size or this many files
+auto constexpr MAX_BATCH_FILES{64U};
+
+// Input file path which stands for the standard input
+auto constexpr STDIN_PATH{"-"};
+
+/**
+ * @brief Counts the characters in the next n bytes of the stream, or in the rest
+ * of the stream if it ends earlier. Stream is read in blocks.
+ *
+ * @param in Input stream
+ * @param n Number of bytes to check
+ * @param characters Characters which we count
+ * @param result Histogram to which counts are added
+ */
+void countStream(std::istream& in, std::uintmax_t n, counter::CharacterSet const& characters, Histogram& result) {
+    // Reused by all chunks counted on the same thread
+    thread_local std::vector<char> block(CHUNK_SIZE);
+
+    while (n > 0 && in) {
+        auto const to_read = static_cast<std::streamsize>(std::min<std::uintmax_t>(n, block.size()));
+        in.read(block.data(), to_read);
+
+        auto const read = static_cast<std::size_t>(in.gcount());
+        counter::countBlock({block.data(), read}, characters, result);
+        n -= read;
+    }
+}
+
+/**
+ * @brief Returns index of the histogram of the calling thread, tasks run inline use the first one
+ */
+std::size_t workerSlot() noexcept { return static_cast<std::size_t>(std::max(ThreadPool::currentWorker(), 0)); }
+
+Histogram mergeWorkerResults(std::vector<Histogram> const& worker_results) {
+    Histogram result{};
+
+    for (auto const& worker_result : worker_results) {
+        kernel::merge(result, worker_result);
+    }
+
+    return result;
+}
+
+}  // namespace
+
+void FileCounter::FileState::add(Histogram const& counts) {
+    std::lock_guard lock{mutex};
+    kernel::merge(result.counts, counts);
+}
+
+void FileCounter::FileState::fail(std::string error) {
+    std::lock_guard lock{mutex};
+    if (!result.error) {
+        result.error = std::move(error);
+    }
+}
+
+FileCounter::FileCounter(unsigned threads_count, counter::CharacterSet characters, IoBackend io_backend)
+    : threads_count_{std::max(threads_count, 1U)}, characters_{std::move(characters)}, io_backend_{io_backend} {}
+
+std::vector<FileResult> FileCounter::count(std::vector<InputFile> const& files) {
+    std::vector<FileState> states(files.size());
+
+    std::uintmax_t seekable_size = 0;
+    bool has_pipes = false;
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        states[i].file = &files[i];
+        seekable_size += files[i].seekable ? files[i].size : 0;
+        has_pipes = has_pipes || !files[i].seekable;
+    }
+
+    // Starting threads isn't worth it when everything fits in a single chunk
+    if (threads_count_ > 1 && (has_pipes || seekable_size > CHUNK_SIZE)) {
+        pool_ = std::make_unique<ThreadPool>(threads_count_);
+    }
+
+    try {
+        std::vector<Task> tasks;
+        std::vector<FileState*> uring_files;
+        std::vector<FileState*> pipes;
+
+        std::vector<FileState*> batch;
+        std::uintmax_t batch_size = 0;
+
+        auto const flush_batch = [this, &tasks, &batch, &batch_size] {
+            if (batch.empty()) {
+                return;
+            }
+
+            tasks.emplace_back([this, batch = std::move(batch)] {
+                for (auto* state : batch) {
+                    std::ifstream fin{state->file->path, std::ios_base::binary};
+
+                    if (!fin.is_open()) {
+                        state->fail("Cannot open file");
+                        continue;
+                    }
+
+                    Histogram counts{};
+                    countStream(fin, std::numeric_limits<std::uintmax_t>::max(), characters_, counts);
+                    state->add(counts);
+                }
+            });
+
+            batch.clear();
+            batch_size = 0;
+        };
+
+        for (auto& state : states) {
+            auto const& file = *state.file;
+
+            if (!file.seekable) {
+                pipes.push_back(&state);
+            } else if (file.size <= CHUNK_SIZE) {
+                batch.push_back(&state);
+                batch_size += file.size;
+
+                if (batch_size >= CHUNK_SIZE || batch.size() >= MAX_BATCH_FILES) {
+                    flush_batch();
+                }
+            } else if (io_backend_ == IoBackend::uring) {
+                uring_files.push_back(&state);
+            } else {
+                addChunks(state, tasks);
+            }
+        }
+
+        flush_batch();
+
+        // Contiguous runs keep every worker reading sequentially, idle workers steal from the end of the other runs
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            run(static_cast<unsigned>(i * threads_count_ / tasks.size()), std::move(tasks[i]));
+        }
+
+        // Sequential inputs are read by this thread while the pool counts the chunks
+        for (auto* state : uring_files) {
+            if (!countUring(*state)) {
+                std::vector<Task> fallback;
+                addChunks(*state, fallback);
+
+                for (std::size_t i = 0; i < fallback.size(); ++i) {
+                    run(static_cast<unsigned>(i), std::move(fallback[i]));
+                }
+            }
+        }
+
+        for (auto* state : pipes) {
+            countPipe(*state);
+        }
+
+        wait();
+    } catch (...) {
+        // Queued tasks still reference the file states
+        wait();
+        throw;
+    }
+
+    std::vector<FileResult> results;
+    results.reserve(states.size());
+
+    for (auto& state : states) {
+        results.emplace_back(std::move(state.result));
+    }
+
+    return results;
+}
+
+void FileCounter::addChunks(FileState& state, std::vector<Task>& tasks) {
+    auto const& file = *state.file;
+
+    if (io_backend_ != IoBackend::stream) {
+        try {
+            state.mapped_file.emplace(file.path);
+        } catch (std::system_error const& e) {
+            if (io_backend_ == IoBackend::mmap) {
+                state.fail(e.what());
+                return;
+            }
+            // Otherwise fall back to the stream reading
+        }
+    }
+
+    auto const size = state.mapped_file ? state.mapped_file->size() : file.size;
+
+    for (std::uintmax_t start_pos = 0; start_pos < size; start_pos += CHUNK_SIZE) {
+        auto const chunk_size = std::min(CHUNK_SIZE, size - start_pos);
+
+        tasks.emplace_back([this, &state, start_pos, chunk_size] {
+            Histogram counts{};
+
+            if (state.mapped_file) {
+                state.mapped_file->prefetch(start_pos, chunk_size);
+                counter::countBlock(state.mapped_file->slice(start_pos, chunk_size), characters_, counts);
+            } else {
+                std::ifstream fin{state.file->path, std::ios_base::binary};
+
+                if (!fin.is_open()) {
+                    state.fail("Cannot open file");
+                    return;
+                }
+
+                fin.seekg(start_pos);
+                countStream(fin, chunk_size, characters_, counts);
+            }
+
+            state.add(counts);
+        });
+    }
+}
+
+bool FileCounter::countUring(FileState& state) {
+    auto const workers_count = pool_ ? pool_->size() : 1U;
+
+    try {
+        // Every worker can hold one buffer while the queue is still full
+        BufferPool buffers{URING_QUEUE_DEPTH + workers_count, CHUNK_SIZE};
+        UringReader reader{state.file->path, buffers, URING_QUEUE_DEPTH};
+
+        std::vector<Histogram> worker_results(workers_count, Histogram{});
+        std::vector<std::future<void>> blocks;
+
+        try {
+            reader.read([this, &buffers, &worker_results, &blocks](std::size_t index, std::string_view block) {
+                auto task = [this, &buffers, &worker_results, index, block] {
+                    counter::countBlock(block, characters_, worker_results[workerSlot()]);
+                    buffers.release(index);
+                };
+
+                if (pool_) {
+                    blocks.emplace_back(pool_->submit(std::move(task)));
+                } else {
+                    task();
+                }
+            });
+        } catch (...) {
+            // Queued blocks still use the buffers and worker results
+            std::for_each(blocks.begin(), blocks.end(), std::mem_fn(&std::future<void>::wait));
+            throw;
+        }
+
+        std::for_each(blocks.begin(), blocks.end(), std::mem_fn(&std::future<void>::get));
+
+        state.add(mergeWorkerResults(worker_results));
+        return true;
+    } catch (std::system_error const& e) {
+        // Nothing was added to the file result, file is counted again with the default backend
+        std::cerr << "Warning: io_uring cannot be used for \"" << state.file->path << "\" (" << e.what()
+                  << "), file is read with the default backend" << std::endl;
+        return false;
+    }
+}
+
+void FileCounter::countPipe(FileState& state) {
+    auto const& file = *state.file;
+
+    auto const fd = file.path == STDIN_PATH ? STDIN_FILENO : ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        state.fail(std::strerror(errno));
+        return;
+    }
+
+    auto const workers_count = pool_ ? pool_->size() : 1U;
+
+    // Two buffers per worker keep the reader busy while the workers count
+    BufferPool buffers{2 * workers_count, CHUNK_SIZE};
+
+    std::vector<Histogram> worker_results(workers_count, Histogram{});
+
+    for (bool eof = false; !eof;) {
+        auto const index = buffers.acquire();
+        auto* const data = buffers.data(index);
+
+        // Pipes return at most their capacity per read, fill the whole buffer before counting
+        std::size_t filled = 0;
+        while (filled < buffers.bufferSize()) {
+            auto const ret = ::read(fd, data + filled, buffers.bufferSize() - filled);
+
+            if (ret > 0) {
+                filled += static_cast<std::size_t>(ret);
+            } else if (ret == 0) {
+                eof = true;
+                break;
+            } else if (errno != EINTR) {
+                state.fail(std::strerror(errno));
+                eof = true;
+                break;
+            }
+        }
+
+        if (filled == 0) {
+            buffers.release(index);
+            continue;
+        }
+
+        auto task = [this, &buffers, &worker_results, index, block = std::string_view{data, filled}] {
+            counter::countBlock(block, characters_, worker_results[workerSlot()]);
+            buffers.release(index);
+        };
+
+        if (pool_) {
+            pool_->post(std::move(task));
+        } else {
+            task();
+        }
+    }
+
+    // All buffers are back in the pool once every block is counted
+    for (std::size_t i = 0; i < buffers.count(); ++i) {
+        buffers.acquire();
+    }
+
+    if (fd != STDIN_FILENO) {
+        ::close(fd);
+    }
+
+    state.add(mergeWorkerResults(worker_results));
+}
+
+void FileCounter::run(unsigned worker, Task task) {
+    if (pool_) {
+        pending_.emplace_back(pool_->submit(worker, std::move(task)));
+    } else {
+        task();
+    }
+}
+
+void FileCounter::wait() {
+    std::for_each(pending_.begin(), pending_.end(), std::mem_fn(&std::future<void>::wait));
+    pending_.clear();
+}
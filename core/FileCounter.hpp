@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Counter.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+enum class IoBackend { automatic, mmap, stream, uring };
+
+/**
+ * @brief Input which is counted
+ */
+struct InputFile {
+    // Path to the file, "-" stands for the standard input
+    std::string path;
+    // Regular files can be split into chunks, the other inputs are read sequentially
+    bool seekable;
+    std::uintmax_t size;
+};
+
+/**
+ * @brief Counting result of a single input
+ */
+struct FileResult {
+    counter::Histogram counts{};
+    std::optional<std::string> error;
+};
+
+/**
+ * @brief Counts characters in many inputs on one shared thread pool.
+ *
+ * Large files are split into cache sized chunks, small files are batched so
+ * that a single task reads several of them. All chunks and batches are placed
+ * in one list which is split into contiguous runs between the workers, idle
+ * workers steal the work of the others. Pipes and io_uring reads are driven
+ * by the calling thread while the pool counts.
+ */
+class FileCounter {
+public:
+    /**
+     * @param threads_count Number of counting threads
+     * @param characters Characters which we count
+     * @param io_backend Backend used for reading regular files
+     */
+    FileCounter(unsigned threads_count, counter::CharacterSet characters, IoBackend io_backend);
+
+    /**
+     * @brief Counts characters in all files
+     *
+     * @param files Inputs
+     * @return Results in the order of the inputs
+     */
+    std::vector<FileResult> count(std::vector<InputFile> const& files);
+
+private:
+    using Task = std::function<void()>;
+
+    struct FileState {
+        InputFile const* file{nullptr};
+        std::optional<MappedFile> mapped_file;
+
+        std::mutex mutex;
+        FileResult result;
+
+        void add(counter::Histogram const& counts);
+        void fail(std::string error);
+    };
+
+    /**
+     * @brief Appends chunk tasks of a large file to the task list
+     */
+    void addChunks(FileState& state, std::vector<Task>& tasks);
+
+    /**
+     * @brief Counts a large file with the io_uring reader on the calling thread
+     *
+     * @return False if io_uring cannot be used for the file
+     */
+    bool countUring(FileState& state);
+
+    /**
+     * @brief Counts a non seekable input on the calling thread
+     */
+    void countPipe(FileState& state);
+
+    /**
+     * @brief Runs the task on the pool, or inline when there is no pool
+     */
+    void run(unsigned worker, Task task);
+
+    /**
+     * @brief Waits for all tasks run on the pool
+     */
+    void wait();
+
+    unsigned threads_count_;
+    counter::CharacterSet characters_;
+    IoBackend io_backend_;
+
+    std::unique_ptr<ThreadPool> pool_;
+    std::vector<std::future<void>> pending_;
+};
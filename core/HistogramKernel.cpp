@@ -0,0 +1,64 @@
+#include "HistogramKernel.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+auto constexpr SUB_TABLES_COUNT{4U};
+
+// 32-bit sub-table counters cannot overflow within a single block
+auto constexpr MAX_BLOCK_SIZE{std::size_t{1} << 30};
+
+using SubTables = std::array<std::array<std::uint32_t, 256>, SUB_TABLES_COUNT>;
+
+void histogramBlock(unsigned char const* data, std::size_t size, SubTables& tables) noexcept {
+    std::size_t i = 0;
+
+    for (; size - i >= sizeof(std::uint64_t); i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+
+        ++tables[0][word & 0xFF];
+        ++tables[1][(word >> 8) & 0xFF];
+        ++tables[2][(word >> 16) & 0xFF];
+        ++tables[3][(word >> 24) & 0xFF];
+        ++tables[0][(word >> 32) & 0xFF];
+        ++tables[1][(word >> 40) & 0xFF];
+        ++tables[2][(word >> 48) & 0xFF];
+        ++tables[3][(word >> 56) & 0xFF];
+    }
+
+    for (; i < size; ++i) {
+        ++tables[i % SUB_TABLES_COUNT][data[i]];
+    }
+}
+
+}  // namespace
+
+void kernel::histogram(std::string_view data, Histogram& result) noexcept {
+    auto const* bytes = reinterpret_cast<unsigned char const*>(data.data());
+    auto size = data.size();
+
+    while (size > 0) {
+        SubTables tables{};
+
+        auto const block_size = std::min(size, MAX_BLOCK_SIZE);
+        histogramBlock(bytes, block_size, tables);
+
+        for (std::size_t value = 0; value < result.size(); ++value) {
+            for (auto const& table : tables) {
+                result[value] += table[value];
+            }
+        }
+
+        bytes += block_size;
+        size -= block_size;
+    }
+}
+
+void kernel::merge(Histogram& result, Histogram const& other) noexcept {
+    for (std::size_t value = 0; value < result.size(); ++value) {
+        result[value] += other[value];
+    }
+}
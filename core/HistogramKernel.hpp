@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace kernel {
+
+/**
+ * @brief Occurence count of every byte value, indexed by unsigned byte value
+ */
+using Histogram = std::array<std::uint64_t, 256>;
+
+/**
+ * @brief Adds occurence counts of all byte values in data to result.
+ * Consecutive bytes are counted into separate interleaved sub-tables, so
+ * repeated bytes don't wait on the store of the previous increment of the
+ * same counter. Sub-tables are merged into result at the end.
+ *
+ * @param data Data
+ * @param result Histogram to which counts are added
+ */
+void histogram(std::string_view data, Histogram& result) noexcept;
+
+/**
+ * @brief Adds all counts of other histogram to result
+ *
+ * @param result Histogram to which counts are added
+ * @param other Histogram which is added
+ */
+void merge(Histogram& result, Histogram const& other) noexcept;
+
+}  // namespace kernel
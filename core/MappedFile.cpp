@@ -0,0 +1,100 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+[[noreturn]] void throwErrno(char const* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+}  // namespace
+
+MappedFile::MappedFile(std::filesystem::path const& path) {
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throwErrno("MappedFile > Open");
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        auto const error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "MappedFile > Stat");
+    }
+
+    // Pipes and special files cannot be mapped
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::system_error(std::make_error_code(std::errc::not_supported), "MappedFile > Not a regular file");
+    }
+
+    size_ = static_cast<std::uintmax_t>(st.st_size);
+
+    // Empty file cannot be mapped, but there is also nothing to read
+    if (size_ != 0) {
+        auto* const addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (addr == MAP_FAILED) {
+            auto const error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "MappedFile > Map");
+        }
+
+        data_ = static_cast<char*>(addr);
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)} {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    return *this;
+}
+
+std::string_view MappedFile::slice(std::uintmax_t offset, std::uintmax_t size) const noexcept {
+    if (offset >= size_) {
+        return {};
+    }
+
+    return {data_ + offset, static_cast<std::size_t>(std::min(size, size_ - offset))};
+}
+
+void MappedFile::prefetch(std::uintmax_t offset, std::uintmax_t size) const noexcept {
+    auto const part = slice(offset, size);
+    if (part.empty()) {
+        return;
+    }
+
+    // madvise requires page aligned address
+    static auto const page_size = static_cast<std::uintmax_t>(::sysconf(_SC_PAGESIZE));
+    auto const aligned_offset = offset - offset % page_size;
+
+    ::madvise(data_ + aligned_offset, part.size() + (offset - aligned_offset), MADV_WILLNEED);
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+/**
+ * @brief Read only memory mapping of a whole file. File is mapped once and
+ * workers get views over their parts of it without copying.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps the file and advises the kernel that it will be read sequentially
+     *
+     * @param path Path to the file
+     * @throw std::system_error If the file cannot be opened or mapped
+     */
+    explicit MappedFile(std::filesystem::path const& path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    std::uintmax_t size() const noexcept { return size_; }
+
+    /**
+     * @brief Returns view over [offset, offset + size) part of the file. Range is
+     * clamped to the end of the file.
+     *
+     * @param offset Offset of the first byte
+     * @param size Number of bytes
+     * @return View over the file part
+     */
+    std::string_view slice(std::uintmax_t offset, std::uintmax_t size) const noexcept;
+
+    /**
+     * @brief Asks the kernel to start reading [offset, offset + size) part of the
+     * file ahead of the access (MADV_WILLNEED)
+     *
+     * @param offset Offset of the first byte
+     * @param size Number of bytes
+     */
+    void prefetch(std::uintmax_t offset, std::uintmax_t size) const noexcept;
+
+private:
+    void unmap() noexcept;
+
+    char* data_{nullptr};
+    std::uintmax_t size_{0};
+};
@@ -0,0 +1,115 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace {
+
+thread_local ThreadPool const* current_pool{nullptr};
+thread_local int current_worker{-1};
+
+}  // namespace
+
+ThreadPool::ThreadPool(unsigned threads_count) {
+    threads_count = std::max(threads_count, 1U);
+
+    queues_.reserve(threads_count);
+    for (unsigned i = 0; i < threads_count; ++i) {
+        queues_.emplace_back(std::make_unique<Queue>());
+    }
+
+    threads_.reserve(threads_count);
+    for (unsigned i = 0; i < threads_count; ++i) {
+        threads_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+void ThreadPool::post(Task task) {
+    if (current_pool == this) {
+        post(static_cast<unsigned>(current_worker), std::move(task));
+    } else {
+        post(next_queue_.fetch_add(1, std::memory_order_relaxed), std::move(task));
+    }
+}
+
+void ThreadPool::post(unsigned worker, Task task) {
+    auto& queue = *queues_[worker % queues_.size()];
+    {
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.emplace_back(std::move(task));
+    }
+
+    // Counter is raised under the pool mutex, so a worker about to sleep cannot miss it
+    {
+        std::lock_guard lock{mutex_};
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    cv_.notify_one();
+}
+
+int ThreadPool::currentWorker() noexcept { return current_worker; }
+
+void ThreadPool::workerLoop(unsigned index) {
+    current_pool = this;
+    current_worker = static_cast<int>(index);
+
+    while (true) {
+        Task task;
+
+        if (tryPop(index, task) || trySteal(index, task)) {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            continue;
+        }
+
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+
+        if (stop_ && pending_.load(std::memory_order_relaxed) <= 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::tryPop(unsigned index, Task& task) {
+    auto& queue = *queues_[index];
+    std::lock_guard lock{queue.mutex};
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::trySteal(unsigned thief, Task& task) {
+    auto const queues_count = static_cast<unsigned>(queues_.size());
+
+    for (unsigned i = 1; i < queues_count; ++i) {
+        auto& queue = *queues_[(thief + i) % queues_count];
+        std::unique_lock lock{queue.mutex, std::try_to_lock};
+
+        if (!lock.owns_lock() || queue.tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Persistent pool of threads with per thread task queues and work stealing.
+ * Owner takes tasks from the front of its queue, idle threads steal from the back
+ * of the other queues.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts threads_count worker threads
+     *
+     * @param threads_count Number of worker threads, at least 1
+     */
+    explicit ThreadPool(unsigned threads_count);
+
+    /**
+     * @brief Finishes all queued tasks and joins worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    unsigned size() const noexcept { return static_cast<unsigned>(queues_.size()); }
+
+    /**
+     * @brief Queues the task. When called from a worker thread task goes to its own
+     * queue, otherwise queues are chosen round robin.
+     *
+     * @param task Task
+     */
+    void post(Task task);
+
+    /**
+     * @brief Queues the task to the queue of a specific worker
+     *
+     * @param worker Worker index, taken modulo size()
+     * @param task Task
+     */
+    void post(unsigned worker, Task task);
+
+    /**
+     * @brief Queues the function, queue is chosen same as for post(Task)
+     *
+     * @tparam F Function type
+     * @param f Function
+     * @return Future of the function result
+     */
+    template <class F>
+    std::future<std::invoke_result_t<std::decay_t<F>&>> submit(F&& f);
+
+    /**
+     * @brief Queues the function to the queue of a specific worker
+     *
+     * @tparam F Function type
+     * @param worker Worker index, taken modulo size()
+     * @param f Function
+     * @return Future of the function result
+     */
+    template <class F>
+    std::future<std::invoke_result_t<std::decay_t<F>&>> submit(unsigned worker, F&& f);
+
+    /**
+     * @brief Returns index of the calling worker thread or -1 if it isn't a worker of any pool
+     */
+    static int currentWorker() noexcept;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned index);
+
+    bool tryPop(unsigned index, Task& task);
+    bool trySteal(unsigned thief, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // Can go below zero for a moment when task is taken before its post is accounted
+    std::atomic<std::ptrdiff_t> pending_{0};
+    std::atomic<unsigned> next_queue_{0};
+    bool stop_{false};
+};
+
+// DEFINITIONS
+
+template <class F>
+std::future<std::invoke_result_t<std::decay_t<F>&>> ThreadPool::submit(F&& f) {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future = task->get_future();
+
+    post([task] { (*task)(); });
+
+    return future;
+}
+
+template <class F>
+std::future<std::invoke_result_t<std::decay_t<F>&>> ThreadPool::submit(unsigned worker, F&& f) {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future = task->get_future();
+
+    post(worker, [task] { (*task)(); });
+
+    return future;
+}
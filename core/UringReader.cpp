@@ -0,0 +1,265 @@
+#include "UringReader.hpp"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace {
+
+[[noreturn]] void throwError(int error, char const* what) {
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+template <class T>
+T* ringField(void* ring, std::uint32_t offset) noexcept {
+    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+}  // namespace
+
+UringReader::UringReader(std::filesystem::path const& path, BufferPool& buffers, unsigned queue_depth)
+    : buffers_{buffers}, queue_depth_{std::max(queue_depth, 1U)}, reads_(buffers.count()) {
+    try {
+        // O_DIRECT bypasses the page cache, but isn't supported by every filesystem (e.g. tmpfs)
+        file_fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        direct_ = file_fd_ >= 0;
+
+        if (!direct_) {
+            file_fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+
+        if (file_fd_ < 0) {
+            throwError(errno, "UringReader > Open");
+        }
+
+        struct stat st {};
+        if (::fstat(file_fd_, &st) != 0) {
+            throwError(errno, "UringReader > Stat");
+        }
+
+        if (!S_ISREG(st.st_mode)) {
+            throwError(ENOTSUP, "UringReader > Not a regular file");
+        }
+
+        size_ = static_cast<std::uintmax_t>(st.st_size);
+
+        setupRing(queue_depth_);
+
+        // Registered buffers save page pinning on every read, but registration is limited by RLIMIT_MEMLOCK
+        std::vector<iovec> iovecs(buffers_.count());
+        for (std::size_t i = 0; i < iovecs.size(); ++i) {
+            iovecs[i].iov_base = buffers_.data(i);
+            iovecs[i].iov_len = buffers_.bufferSize();
+        }
+
+        registered_ = ::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                static_cast<unsigned>(iovecs.size())) == 0;
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+UringReader::~UringReader() { close(); }
+
+void UringReader::setupRing(unsigned entries) {
+    io_uring_params params{};
+
+    ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) {
+        throwError(errno, "UringReader > Setup");
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // Newer kernels map both rings with a single mmap
+    bool const single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        throwError(errno, "UringReader > Map SQ");
+    }
+
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                          IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            throwError(errno, "UringReader > Map CQ");
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto* const sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                              IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        throwError(errno, "UringReader > Map SQEs");
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_tail_ = ringField<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = ringField<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = ringField<unsigned>(sq_ring_, params.sq_off.array);
+    cq_head_ = ringField<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = ringField<unsigned>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = ringField<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = ringField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+}
+
+void UringReader::close() noexcept {
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+
+    if (sq_ring_ != nullptr) {
+        ::munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+
+    // Closing the ring also unregisters the buffers
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+
+    if (file_fd_ >= 0) {
+        ::close(file_fd_);
+        file_fd_ = -1;
+    }
+}
+
+void UringReader::read(BlockHandler const& on_block) {
+    auto const buffer_size = buffers_.bufferSize();
+
+    std::uintmax_t next_offset = 0;
+    unsigned in_flight = 0;
+    error_ = 0;
+
+    // After a failed read no new reads are queued, but the kernel may still write into the buffers of
+    // the reads in flight, so their completions are waited for before throwing
+    while ((error_ == 0 && next_offset < size_) || in_flight > 0) {
+        // Keep the queue full while there are free buffers
+        std::size_t index;
+        while (error_ == 0 && next_offset < size_ && in_flight < queue_depth_ && buffers_.tryAcquire(index)) {
+            prepareRead(index, next_offset, 0);
+            next_offset += buffer_size;
+            ++in_flight;
+        }
+
+        // All buffers are being counted, wait until one of them is released
+        if (in_flight == 0) {
+            index = buffers_.acquire();
+            prepareRead(index, next_offset, 0);
+            next_offset += buffer_size;
+            ++in_flight;
+        }
+
+        submitAndWait();
+        in_flight -= reapCompletions(on_block);
+    }
+
+    if (error_ != 0) {
+        throwError(error_, "UringReader > Read");
+    }
+}
+
+void UringReader::prepareRead(std::size_t buffer_index, std::uintmax_t offset, std::size_t filled) {
+    reads_[buffer_index] = {offset, filled};
+
+    auto const tail = *sq_tail_;
+    auto const slot = tail & *sq_mask_;
+
+    auto& sqe = sqes_[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = registered_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = file_fd_;
+    sqe.off = offset + filled;
+    sqe.addr = reinterpret_cast<std::uintptr_t>(buffers_.data(buffer_index) + filled);
+    sqe.len = static_cast<std::uint32_t>(buffers_.bufferSize() - filled);
+    sqe.buf_index = static_cast<std::uint16_t>(buffer_index);
+    sqe.user_data = buffer_index;
+
+    sq_array_[slot] = slot;
+
+    // Kernel may read the entry as soon as it sees the new tail
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++queued_;
+}
+
+void UringReader::submitAndWait() {
+    while (true) {
+        auto const ret = ::syscall(__NR_io_uring_enter, ring_fd_, queued_, 1U, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        if (ret >= 0) {
+            queued_ -= static_cast<unsigned>(ret);
+            return;
+        }
+
+        if (errno != EINTR) {
+            throwError(errno, "UringReader > Enter");
+        }
+    }
+}
+
+unsigned UringReader::reapCompletions(BlockHandler const& on_block) {
+    unsigned finished = 0;
+
+    auto head = *cq_head_;
+    auto const tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        auto const& cqe = cqes_[head & *cq_mask_];
+        auto const index = static_cast<std::size_t>(cqe.user_data);
+        auto const res = cqe.res;
+
+        // Buffer of the failed read and of every read completed after it is not passed to the handler
+        if (res < 0 || error_ != 0) {
+            if (error_ == 0) {
+                error_ = -res;
+            }
+
+            buffers_.release(index);
+            ++finished;
+            continue;
+        }
+
+        auto const [offset, filled_before] = reads_[index];
+        auto const filled = filled_before + static_cast<std::size_t>(res);
+        auto const expected = static_cast<std::size_t>(std::min<std::uintmax_t>(buffers_.bufferSize(), size_ - offset));
+
+        if (res == 0 || filled >= expected) {
+            on_block(index, {buffers_.data(index), std::min(filled, expected)});
+            ++finished;
+        } else {
+            // Short read, read the rest of the buffer
+            prepareRead(index, offset, filled);
+        }
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    return finished;
+}
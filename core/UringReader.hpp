@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "BufferPool.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief Asynchronous file reader which keeps several reads in flight through
+ * io_uring. Buffers of the pool are registered with the ring and file is opened
+ * with O_DIRECT when the filesystem allows it, so reads go straight from the
+ * device to the counting buffers.
+ */
+class UringReader {
+public:
+    /**
+     * @brief Handler of the filled buffer. Handler owns the buffer and must release
+     * it to the pool when it is done with it, possibly later and from another thread.
+     */
+    using BlockHandler = std::function<void(std::size_t buffer_index, std::string_view block)>;
+
+    /**
+     * @brief Opens the file and sets up the ring
+     *
+     * @param path Path to the file
+     * @param buffers Buffer pool, must outlive the reader
+     * @param queue_depth Maximal number of reads in flight
+     * @throw std::system_error If io_uring is not available or file cannot be opened
+     */
+    UringReader(std::filesystem::path const& path, BufferPool& buffers, unsigned queue_depth);
+
+    ~UringReader();
+
+    UringReader(UringReader const&) = delete;
+    UringReader& operator=(UringReader const&) = delete;
+
+    std::uintmax_t size() const noexcept { return size_; }
+    bool isDirect() const noexcept { return direct_; }
+
+    /**
+     * @brief Reads the whole file and passes every filled buffer to on_block
+     * in the order of completion
+     *
+     * @param on_block Filled buffer handler
+     * @throw std::system_error If some read fails, after all reads in flight are completed
+     */
+    void read(BlockHandler const& on_block);
+
+private:
+    struct PendingRead {
+        std::uintmax_t offset;
+        std::size_t filled;
+    };
+
+    void setupRing(unsigned entries);
+    void close() noexcept;
+
+    /**
+     * @brief Queues read of the rest of the buffer starting at offset + filled
+     */
+    void prepareRead(std::size_t buffer_index, std::uintmax_t offset, std::size_t filled);
+
+    /**
+     * @brief Submits queued reads and waits for at least one completion
+     */
+    void submitAndWait();
+
+    /**
+     * @brief Handles all available completions
+     *
+     * @return Number of finished buffers
+     */
+    unsigned reapCompletions(BlockHandler const& on_block);
+
+    BufferPool& buffers_;
+    unsigned queue_depth_;
+
+    int file_fd_{-1};
+    int ring_fd_{-1};
+    std::uintmax_t size_{0};
+    bool direct_{false};
+    bool registered_{false};
+
+    void* sq_ring_{nullptr};
+    std::size_t sq_ring_size_{0};
+    void* cq_ring_{nullptr};
+    std::size_t cq_ring_size_{0};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sqes_size_{0};
+
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_mask_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned* cq_mask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+
+    unsigned queued_{0};
+    std::vector<PendingRead> reads_;
+    // Error of the first failed read, remaining reads are drained before it's thrown
+    int error_{0};
+};
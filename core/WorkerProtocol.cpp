@@ -0,0 +1,125 @@
+#include "WorkerProtocol.hpp"
+
+#include <stdexcept>
+
+namespace worker {
+
+namespace {
+
+std::size_t constexpr BITMAP_SIZE{32};
+
+template <class T>
+void encodeInteger(T value, char* out) noexcept {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+template <class T>
+T decodeInteger(char const* in) noexcept {
+    T value{0};
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+}  // namespace
+
+RequestHeader encodeRequestHeader(RequestType type, counter::CharacterSet const& characters,
+                                  std::size_t payload_size) {
+    RequestHeader header{};
+
+    auto const body_size = REQUEST_HEADER_SIZE - FRAME_PREFIX_SIZE + payload_size;
+    if (body_size > MAX_FRAME_SIZE) {
+        throw std::runtime_error("Request payload is too large");
+    }
+
+    encodeInteger(static_cast<std::uint32_t>(body_size), header.data());
+    header[FRAME_PREFIX_SIZE] = static_cast<char>(type);
+
+    auto* const bitmap = header.data() + FRAME_PREFIX_SIZE + 1;
+    for (auto const c : characters.characters()) {
+        auto const value = static_cast<unsigned char>(c);
+        bitmap[value / 8] = static_cast<char>(bitmap[value / 8] | (1 << (value % 8)));
+    }
+
+    return header;
+}
+
+Request decodeRequest(std::string_view body) {
+    if (body.size() < 1 + BITMAP_SIZE) {
+        throw std::runtime_error("Request frame is too short");
+    }
+
+    auto const type = static_cast<RequestType>(body[0]);
+    if (type != RequestType::data && type != RequestType::file && type != RequestType::ping) {
+        throw std::runtime_error("Unknown request type");
+    }
+
+    Request request{type, {}, body.substr(1 + BITMAP_SIZE)};
+
+    for (unsigned value = 0; value < 256; ++value) {
+        if (static_cast<unsigned char>(body[1 + value / 8]) & (1U << (value % 8))) {
+            request.characters.insert(static_cast<char>(value));
+        }
+    }
+
+    return request;
+}
+
+std::string encodeResponse(Response const& response) {
+    auto const body_size =
+        1 + (response.status == Status::ok ? response.counts.size() * sizeof(std::uint64_t) : response.error.size());
+
+    std::string frame(FRAME_PREFIX_SIZE + body_size, '\0');
+    encodeInteger(static_cast<std::uint32_t>(body_size), frame.data());
+    frame[FRAME_PREFIX_SIZE] = static_cast<char>(response.status);
+
+    auto* out = frame.data() + FRAME_PREFIX_SIZE + 1;
+
+    if (response.status == Status::ok) {
+        for (auto const count : response.counts) {
+            encodeInteger(count, out);
+            out += sizeof(std::uint64_t);
+        }
+    } else {
+        response.error.copy(out, response.error.size());
+    }
+
+    return frame;
+}
+
+Response decodeResponse(std::string_view body) {
+    if (body.empty()) {
+        throw std::runtime_error("Response frame is empty");
+    }
+
+    Response response{static_cast<Status>(body[0]), {}, {}};
+    body.remove_prefix(1);
+
+    switch (response.status) {
+        case Status::ok:
+            if (body.size() % sizeof(std::uint64_t) != 0) {
+                throw std::runtime_error("Response counts are malformed");
+            }
+
+            for (std::size_t i = 0; i < body.size(); i += sizeof(std::uint64_t)) {
+                response.counts.push_back(decodeInteger<std::uint64_t>(body.data() + i));
+            }
+            break;
+        case Status::error:
+            response.error = body;
+            break;
+        case Status::pong:
+            break;
+        default:
+            throw std::runtime_error("Unknown response status");
+    }
+
+    return response;
+}
+
+std::uint32_t decodeFrameSize(char const* prefix) noexcept { return decodeInteger<std::uint32_t>(prefix); }
+
+}  // namespace worker
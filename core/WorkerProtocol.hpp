@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Counter.hpp"
+
+/**
+ * Framed binary protocol between the server and `chcount --worker` processes.
+ *
+ * Every frame is a 32-bit little endian body size followed by the body.
+ *
+ * Request body:  type (u8), character set bitmap (32 bytes, bit N set if byte value N
+ *                is counted), payload (data which is counted, or a file path)
+ * Response body: status (u8), counts of the requested characters in ascending unsigned
+ *                byte order (u64 little endian each), or an error message
+ *
+ * Worker answers every request with exactly one response, in order.
+ */
+namespace worker {
+
+enum class RequestType : std::uint8_t {
+    // Payload is the data which is counted
+    data = 0,
+    // Payload is a path of the file which is counted
+    file = 1,
+    // Health check, answered with Status::pong
+    ping = 2
+};
+
+enum class Status : std::uint8_t { ok = 0, error = 1, pong = 2 };
+
+// Size of the frame size prefix
+std::size_t constexpr FRAME_PREFIX_SIZE{4};
+
+// Size of the request frame up to the payload, including the frame size prefix
+std::size_t constexpr REQUEST_HEADER_SIZE{FRAME_PREFIX_SIZE + 1 + 32};
+
+// Frames bigger than this are rejected as malformed
+std::size_t constexpr MAX_FRAME_SIZE{std::size_t{1} << 30};
+
+using RequestHeader = std::array<char, REQUEST_HEADER_SIZE>;
+
+struct Request {
+    RequestType type;
+    counter::CharacterSet characters;
+    std::string_view payload;
+};
+
+struct Response {
+    Status status;
+    std::vector<std::uint64_t> counts;
+    std::string error;
+};
+
+/**
+ * @brief Encodes the request frame up to the payload. Payload is sent right after the
+ * header, so it doesn't have to be copied into the frame.
+ *
+ * @param type Request type
+ * @param characters Characters which are counted
+ * @param payload_size Payload size in bytes
+ */
+RequestHeader encodeRequestHeader(RequestType type, counter::CharacterSet const& characters,
+                                  std::size_t payload_size);
+
+/**
+ * @brief Decodes the request frame body (frame without the size prefix).
+ * Returned payload points into body. Throws std::runtime_error on malformed body.
+ */
+Request decodeRequest(std::string_view body);
+
+/**
+ * @brief Encodes the whole response frame, including the frame size prefix
+ */
+std::string encodeResponse(Response const& response);
+
+/**
+ * @brief Decodes the response frame body (frame without the size prefix).
+ * Throws std::runtime_error on malformed body.
+ */
+Response decodeResponse(std::string_view body);
+
+/**
+ * @brief Decodes the frame size prefix
+ *
+ * @param prefix FRAME_PREFIX_SIZE bytes
+ */
+std::uint32_t decodeFrameSize(char const* prefix) noexcept;
+
+}  // namespace worker
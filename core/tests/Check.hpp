@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace test {
+
+/**
+ * @brief Returns the number of the failed checks, test fails if it's not 0
+ */
+inline unsigned& getFailedChecks() noexcept {
+    static unsigned failed_checks = 0;
+    return failed_checks;
+}
+
+/**
+ * @brief Reports the failed check when the values differ
+ *
+ * @param actual Tested value
+ * @param expected Reference value
+ * @param what Description of the checked case
+ * @return True if the values are equal
+ */
+template <class T, class U>
+bool checkEqual(T const& actual, U const& expected, std::string const& what) {
+    if (actual == expected) {
+        return true;
+    }
+
+    ++getFailedChecks();
+    std::cerr << "FAILED " << what << ": " << actual << " != " << expected << std::endl;
+    return false;
+}
+
+/**
+ * @brief Returns the process exit code of the test
+ */
+inline int getResult() noexcept { return getFailedChecks() == 0 ? EXIT_SUCCESS : EXIT_FAILURE; }
+
+}  // namespace test
@@ -0,0 +1,99 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "CountKernel.hpp"
+
+// Alignment of the test buffers, larger than any kernel step
+auto constexpr BUFFER_ALIGNMENT{64U};
+
+// Random data sets per instruction set
+auto constexpr RANDOM_CASES{1000U};
+
+namespace {
+
+std::vector<kernel::Isa> const SIMD_ISAS{kernel::Isa::sse2, kernel::Isa::avx2, kernel::Isa::avx512};
+
+/**
+ * @brief Fills the data with bytes which are value in the given percent of the positions, the other bytes are
+ * random and can also be value
+ */
+void fill(std::string& data, char value, unsigned density, std::mt19937& generator) {
+    std::uniform_int_distribution<unsigned> percent{0, 99};
+    std::uniform_int_distribution<int> byte{0, 255};
+
+    for (auto& c : data) {
+        c = percent(generator) < density ? value : static_cast<char>(byte(generator));
+    }
+}
+
+/**
+ * @brief Checks the kernel against the scalar reference on data which starts offset bytes after the aligned
+ * address, so both the unaligned head and the tail shorter than a kernel step are covered
+ */
+void checkKernel(kernel::Isa isa, std::size_t size, std::size_t offset, char value, unsigned density,
+                 std::mt19937& generator) {
+    std::string buffer(size + offset + 2 * BUFFER_ALIGNMENT, '\0');
+    fill(buffer, value, density, generator);
+
+    auto const misalignment = reinterpret_cast<std::uintptr_t>(buffer.data()) % BUFFER_ALIGNMENT;
+    auto const* data = buffer.data() + (BUFFER_ALIGNMENT - misalignment) + offset;
+
+    auto const expected = kernel::countScalar(data, size, value);
+    auto const actual = kernel::getCountFunction(isa)(data, size, value);
+
+    test::checkEqual(actual, expected,
+                     std::string{kernel::toString(isa)} + " size " + std::to_string(size) + " offset " +
+                         std::to_string(offset) + " value " + std::to_string(static_cast<unsigned char>(value)) +
+                         " density " + std::to_string(density));
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 generator{42};
+
+    std::uniform_int_distribution<std::size_t> small_size{0, 1024};
+    std::uniform_int_distribution<std::size_t> large_size{1024, 70000};
+    std::uniform_int_distribution<std::size_t> offset{0, BUFFER_ALIGNMENT - 1};
+    std::uniform_int_distribution<int> value{0, 255};
+    std::vector<unsigned> const densities{0, 1, 10, 50, 100};
+
+    for (auto const isa : SIMD_ISAS) {
+        if (!kernel::isSupported(isa)) {
+            std::cout << "Skipped " << kernel::toString(isa) << ", not supported by the CPU" << std::endl;
+            continue;
+        }
+
+        // Every size around the kernel steps and every head offset
+        for (std::size_t size = 0; size <= 4 * BUFFER_ALIGNMENT + 1; ++size) {
+            for (std::size_t head = 0; head < BUFFER_ALIGNMENT; ++head) {
+                checkKernel(isa, size, head, 'I', 50, generator);
+            }
+        }
+
+        // Values with the sign bit set, and counts which overflow 8 bit lane accumulators
+        for (auto const c : {'\0', '\x7F', '\x80', '\xFF'}) {
+            checkKernel(isa, 70000, 3, c, 100, generator);
+            checkKernel(isa, 70000, 0, c, 50, generator);
+        }
+
+        for (unsigned i = 0; i < RANDOM_CASES; ++i) {
+            auto const size = i % 4 == 0 ? large_size(generator) : small_size(generator);
+            auto const density = densities[i % densities.size()];
+
+            checkKernel(isa, size, offset(generator), static_cast<char>(value(generator)), density, generator);
+        }
+
+        std::cout << "Checked " << kernel::toString(isa) << std::endl;
+    }
+
+    // Dispatched kernel agrees with the reference as well
+    std::string data(123457, '\0');
+    fill(data, 'I', 10, generator);
+    test::checkEqual(kernel::count(data, 'I'), kernel::countScalar(data.data(), data.size(), 'I'), "dispatched");
+
+    return test::getResult();
+}
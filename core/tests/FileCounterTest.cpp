@@ -0,0 +1,103 @@
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "FileCounter.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<IoBackend> const IO_BACKENDS{IoBackend::stream, IoBackend::mmap, IoBackend::uring};
+
+/**
+ * @brief Test file with its expected counts, removed when the test ends
+ */
+struct TestFile {
+    TestFile(fs::path const& directory, std::size_t size, std::mt19937& generator)
+        : path{directory / ("file_" + std::to_string(size))} {
+        std::uniform_int_distribution<int> byte{0, 255};
+
+        std::string data(size, '\0');
+        for (auto& c : data) {
+            c = static_cast<char>(byte(generator));
+            ++expected[static_cast<unsigned char>(c)];
+        }
+
+        std::ofstream fout{path, std::ios_base::binary};
+        fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    fs::path path;
+    counter::Histogram expected{};
+};
+
+char const* toString(IoBackend io_backend) noexcept {
+    switch (io_backend) {
+        case IoBackend::automatic:
+            return "auto";
+        case IoBackend::mmap:
+            return "mmap";
+        case IoBackend::stream:
+            return "stream";
+        case IoBackend::uring:
+            return "uring";
+    }
+
+    return "";
+}
+
+}  // namespace
+
+int main() {
+    auto const directory = fs::temp_directory_path() / ("chcount_file_counter_test_" + std::to_string(::getpid()));
+    fs::create_directories(directory);
+
+    std::mt19937 generator{42};
+
+    // Empty file, sizes which are not 4K multiples, and files larger than a chunk which are read in parts
+    // (and with io_uring)
+    std::vector<TestFile> files;
+    for (std::size_t const size : {0UL, 1UL, 4095UL, 4097UL, (1UL << 20) + 1, (3UL << 20) + 12345}) {
+        files.emplace_back(directory, size, generator);
+    }
+
+    std::vector<InputFile> inputs;
+    for (auto const& file : files) {
+        inputs.push_back({file.path.string(), true, fs::file_size(file.path)});
+    }
+
+    for (auto const io_backend : IO_BACKENDS) {
+        for (auto const threads_count : {1U, 4U}) {
+            FileCounter file_counter{threads_count, counter::CharacterSet::all(), io_backend};
+            auto const results = file_counter.count(inputs);
+
+            for (std::size_t i = 0; i < files.size(); ++i) {
+                auto const what = std::string{toString(io_backend)} + " threads " + std::to_string(threads_count) +
+                                  " size " + std::to_string(inputs[i].size);
+
+                if (results[i].error) {
+                    test::checkEqual(*results[i].error, std::string{}, what + " error");
+                    continue;
+                }
+
+                for (std::size_t c = 0; c < files[i].expected.size(); ++c) {
+                    if (!test::checkEqual(results[i].counts[c], files[i].expected[c],
+                                          what + " byte " + std::to_string(c))) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+
+    return test::getResult();
+}
@@ -1,6 +1,6 @@
 var host = location.host;
 
-var ws = new WebSocket(`ws://${host}/`);
+var ws = new WebSocket(`ws://${host}/?coalesce=1`);
 var user_id = null;
 var results = {};
 
@@ -23,6 +23,11 @@ const handleResponse = (response) => {
     result_request_id = response?.data?.request_id;
     result = response?.data?.result;
 
+    // Request which cannot be counted
+    if (response?.data?.error !== undefined) {
+      result = `Error: ${response.data.error}`;
+    }
+
     // Request sent
     if (result_request_id in results) {
       setResult(result);
@@ -38,7 +43,12 @@ const handleResponse = (response) => {
 ws.onmessage = (ev) => {
   const response = JSON.parse(ev.data);
 
-  handleResponse(response);
+  // Coalesced messages are sent in a single array
+  if (Array.isArray(response)) {
+    response.forEach(handleResponse);
+  } else {
+    handleResponse(response);
+  }
 };
 
 ws.onerror = (ev) => {